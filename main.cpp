@@ -13,9 +13,12 @@
 #include "ui/Renderer.h"
 #include "ui/ui_macros.h"
 #include "ui/windows/GeneratorManagerWindow.h"
+#include "ui/windows/ArrangementWindow.h"
 #include "ui/windows/GeneratorsWindow.h"
 #include "ui/windows/PianoRollWindow.h"
+#include "ui/windows/SessionWindow.h"
 #include "ui/windows/SettingsWindow.h"
+#include "ui/windows/StepSequencerWindow.h"
 
 int main() {
     audio::AudioBackend backend;
@@ -27,6 +30,9 @@ int main() {
     ui::Windows::GeneratorsWindow generators(&backend);
     ui::Windows::GeneratorManagerWindow generator_manager(&backend,&generators);
     ui::Windows::PianoRollWindow piano_roll(&backend, &generators);
+    ui::Windows::ArrangementWindow arrangement(&backend);
+    ui::Windows::StepSequencerWindow step_sequencer(&backend, &generators);
+    ui::Windows::SessionWindow session(&backend);
 
     window.AddCallback([&] {
         renderer.Begin();
@@ -36,6 +42,9 @@ int main() {
         generators.Render(ctx);
         generator_manager.Render(ctx);
         piano_roll.Render(ctx);
+        arrangement.Render(ctx);
+        step_sequencer.Render(ctx);
+        session.Render(ctx);
 
         renderer.Render();
     });
@@ -6,39 +6,35 @@
 #include <stdexcept>
 
 #include "audio_math.h"
+#include "dsp/DspKernels.h"
 #include "Generators/WaveformGenerator.h"
 
 alignas(32) float buffer[BUFFER_SIZE * 2];
 
 void data_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
 {
+    const double host_time = audio::midi::ClockMapper::host_now();
     auto* out = static_cast<float*>(pOutput);
     int frames   = static_cast<int>(frameCount);
     int floats   = frames * 2;
     std::fill(buffer, buffer + floats, 0.0f);
 
-    for (auto& gen : audio::AudioBackend::audio_backend->generators) {
-        gen->Process(buffer, 2, frames, audio::AudioBackend::audio_backend->sequencer_state.get_current_process_sample()); // Still process even if the sequencer is not playing, this simply means no new note events will be generated
-    }
-
-    auto pan = audio::AudioBackend::audio_backend->master_pan;
-    for (int i = 0; i < floats; i+=2) {
-        auto panned = audio::math::pan({buffer[i], buffer[i+1]}, pan);
-        buffer[i] = panned[0];
-        buffer[i+1] = panned[1];
-    }
+    const uint64_t current_sample = audio::AudioBackend::audio_backend->sequencer_state.get_current_process_sample();
+    audio::AudioBackend::audio_backend->midi_manager.clock.observe(host_time, current_sample, frameCount);
 
-    if (audio::AudioBackend::audio_backend->sequencer_state.is_playing_state()) {
-        audio::AudioBackend::audio_backend->sequencer_state.move_forward(frames);
+    // Arpeggiators and note repeats follow the song tempo
+    const double samples_per_quarter = audio::AudioBackend::audio_backend->sequencer_state.get_samples_per_quarter();
+    for (auto& gen : audio::AudioBackend::audio_backend->generators) {
+        gen->effects.samples_per_quarter = samples_per_quarter;
+        gen->Process(buffer, 2, frames, current_sample); // Still process even if the sequencer is not playing, this simply means no new note events will be generated
     }
 
     audio::AudioBackend::audio_backend->sequencer_state.processed(frames);
 
 
-    auto volume = audio::AudioBackend::audio_backend->master_volume;
-    for (int i = 0; i < floats; ++i) {
-        out[i] = buffer[i] * volume;
-    }
+    audio::dsp::kernels().mix_master(out, buffer, frames,
+                                     audio::AudioBackend::audio_backend->master_pan,
+                                     audio::AudioBackend::audio_backend->master_volume);
 }
 
 namespace audio {
@@ -51,6 +47,9 @@ namespace audio {
 
         audio_backend = this;
 
+        // Pick the widest DSP kernels this CPU supports before the device starts pulling blocks
+        dsp::select_kernels(dsp::detect_isa());
+
         ma_device_config config = ma_device_config_init(ma_device_type_playback);
         config.playback.format = ma_format_f32;
         config.playback.channels = 2;
@@ -66,8 +65,6 @@ namespace audio {
             throw std::runtime_error("Failed to start device!!");
         }
 
-        audio::math::init_noise();
-
         // TODO: Remove VVVVVVV
         generators.push_back(new Generators::WaveformGenerator());
 
@@ -79,27 +76,41 @@ namespace audio {
             }
         });
 
-        midi_manager.note_callbacks.emplace_back([this](int note, int velocity) {
-            if (AudioBackend::audio_backend->selected_generator == -1) {
+        // Runs on the MIDI input threads, each (device, channel) plays the generator it is routed to
+        midi_manager.message_callbacks.emplace_back([this](const midi::MidiMessage& message) {
+            if (message.type == midi::MessageType::ControlChange) {
+                midi_manager.learn.handle(message); // Mapped per controller, not through the note routing
                 return;
             }
 
-            auto generator = generators[selected_generator];
-            if (generator) {
-                if (velocity > 0) {
-                    generator->NoteOn({note, velocity});
-                }
-                else {
-                    generator->NoteOff({note, 0}); // NoteOff with velocity 0
-                }
-            } else {
-                std::cerr << "No generator selected or generator is null!" << std::endl;
+            int index = midi_manager.routing.get(message.device, message.channel);
+            if (index == midi::MidiRouting::follow_selection) {
+                index = selected_generator.load(std::memory_order_relaxed);
+            }
+            if (index < 0 || index >= static_cast<int>(generators.size())) {
+                return;
             }
-        });
 
-        midi_manager.general_callbacks.emplace_back([](int status, int note, int velocity) {
-            std::cout << "Status: "<< status << " Note: " << note << " Velocity: " << velocity << std::endl;
+            auto generator = generators[index];
+            if (message.is_note()) {
+                const uint64_t time = message.time != 0 ? message.time : sequencer_state.get_current_process_sample();
+                const auto type = message.type == midi::MessageType::NoteOn ? Sequencing::EventType::NoteOn : Sequencing::EventType::NoteOff;
+                recorder.capture(generator, {time, 0, type, message.key, static_cast<uint8_t>(message.value)});
+            }
+            switch (message.type) {
+                case midi::MessageType::NoteOn:
+                    generator->NoteOn(message.key, static_cast<uint8_t>(message.value), message.time);
+                    break;
+                case midi::MessageType::NoteOff:
+                    generator->NoteOff(message.key, message.time);
+                    break;
+                default:
+                    break; // Generators have no pressure or pitch bend inputs yet
+            }
         });
+
+        // Ports are found and opened in the background, startup does not wait for the MIDI drivers
+        midi_manager.start();
     }
 
     AudioBackend::~AudioBackend() {
@@ -110,6 +121,6 @@ namespace audio {
         if (gen_idx < 0 || gen_idx >= static_cast<int>(generators.size())) {
             return;
         }
-        this->selected_generator = gen_idx;
+        this->selected_generator.store(gen_idx, std::memory_order_relaxed);
     }
 } // audio
\ No newline at end of file
@@ -1,12 +1,14 @@
 #ifndef AUDIOBACKEND_H
 #define AUDIOBACKEND_H
 
+#include <atomic>
 #include <memory>
 #include <miniaudio.h>
 #include <vector>
 
 #include "AudioGenerator.h"
 #include "midi/MidiManager.h"
+#include "Sequencing/Recorder.h"
 #include "Sequencing/SequencerState.h"
 
 namespace audio {
@@ -24,12 +26,13 @@ public:
     std::pmr::vector<AudioGenerator*> generators;
 
     Sequencing::SequencerState sequencer_state;
+    Sequencing::Recorder recorder{sequencer_state}; // Live input into a pattern, see Recorder::arm
 
     midi::MidiManager midi_manager;
 
     void change_generator(int gen_idx);
 private:
-    int selected_generator = -1;
+    std::atomic<int> selected_generator = -1; // Read on the MIDI input threads
     ma_device device{};
 };
 
@@ -4,7 +4,6 @@
 #include <array>
 
 #define SAMPLE_RATE 44100
-#define NOISE_SAMPLES SAMPLE_RATE
 #define BUFFER_SIZE 1024
 #define SLICE_SIZE SAMPLE_RATE
 
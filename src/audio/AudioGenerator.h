@@ -13,7 +13,12 @@
 
 #include "audio_math.h"
 #include "piano.h"
+#include "MpscQueue.h"
+#include "ParameterStore.h"
+#include "SpscQueue.h"
+#include "midi/NoteEffects.h"
 #include "Sequencing/Note.h"
+#include "Sequencing/NoteEvent.h"
 #include "Sequencing/Voice.h"
 
 namespace audio {
@@ -21,7 +26,9 @@ namespace audio {
 class AudioGenerator {
 public:
     explicit AudioGenerator(std::string name) : name(std::move(name)) {
-
+        // Both are read once per rendering segment, so they glide over a few milliseconds instead of stepping
+        parameters.add("Volume", &volume, 0.0f, 1.0f, SAMPLE_RATE / 200);
+        parameters.add("Pan", &pan, -1.0f, 1.0f, SAMPLE_RATE / 200);
     }
     virtual ~AudioGenerator() = default;
     float volume = 0.5f;
@@ -31,23 +38,94 @@ public:
 
     virtual void Process(float *buffer, int channels, int buffer_size, uint64_t current_sample) = 0;
 
-    void NoteOn(Sequencing::Note note) {
-        int buffer_index = write_buffer_index.load(std::memory_order_relaxed);
-        scheduled_note_buffer_on[buffer_index].emplace_back(note);
+    midi::NoteEffectChain effects; // Live and sequenced notes pass through it on the audio thread
+    ParameterStore parameters; // Changes from other threads go through here, applied at their sample
+
+    // Any thread (MIDI input): live notes at an output sample, times already past (or 0) play at the start of the
+    // next block. False when the queue is full.
+    bool NoteOn(uint8_t note, uint8_t velocity, uint64_t time = 0) {
+        return live_events.push({time, 0, Sequencing::EventType::NoteOn, note, velocity});
+    }
+
+    bool NoteOff(uint8_t note, uint64_t time = 0) {
+        return live_events.push({time, 0, Sequencing::EventType::NoteOff, note, 0});
     }
 
-    void NoteOff(Sequencing::Note note) {
-        int buffer_index = write_buffer_index.load(std::memory_order_relaxed);
-        scheduled_note_buffer_off[buffer_index].emplace_back(note); // Velocity is not used for NoteOff
+    // Sequencer thread only: queues a timestamped event for an upcoming block, false when the queue is full.
+    bool Schedule(Sequencing::NoteEvent event) {
+        event.epoch = event_epoch.load(std::memory_order_relaxed);
+        return sequencer_events.push(event);
+    }
+
+    // Sequencer thread only: drops every queued event that has not been applied yet.
+    void FlushScheduled() {
+        event_epoch.fetch_add(1, std::memory_order_release);
     }
 
     std::vector<Sequencing::Voice> voices; // Currently playing voices
 protected:
-    std::vector<Sequencing::Note> scheduled_note_buffer_on[2];
-    std::vector<Sequencing::Note> scheduled_note_buffer_off[2];
-    std::atomic<int> write_buffer_index = 0;
-private:
+    // Audio thread: the block's live and sequenced events after the effect chain, sorted, with every time
+    // inside [current_sample, current_sample + buffer_size). Valid until the next call.
+    const midi::EventBuffer& CollectEvents(uint64_t current_sample, int buffer_size) {
+        block_events.clear();
+        const uint64_t end = current_sample + static_cast<uint64_t>(buffer_size);
 
+        // Live notes due after this block wait for theirs
+        midi::EventBuffer& waiting = live_waiting[live_parity];
+        midi::EventBuffer& later = live_waiting[live_parity ^ 1];
+        live_parity ^= 1;
+        later.clear();
+        const auto place_live = [&](Sequencing::NoteEvent live) {
+            if (live.time >= end) {
+                later.push(live);
+                return;
+            }
+            live.time = std::max(live.time, current_sample);
+            block_events.push(live);
+        };
+        for (const auto& live : waiting) {
+            place_live(live);
+        }
+        Sequencing::NoteEvent event{};
+        while (live_events.pop(event)) {
+            place_live(event);
+        }
+
+        while (NextScheduled(end, event)) {
+            event.time = std::max(event.time, current_sample); // Late events are applied right away
+            block_events.push(event);
+        }
+        block_events.sort();
+        return effects.process(block_events, current_sample, static_cast<uint32_t>(buffer_size));
+    }
+
+    // Audio thread: pops the next sequencer event due before until, skipping flushed ones.
+    bool NextScheduled(uint64_t until, Sequencing::NoteEvent& out) {
+        const Sequencing::NoteEvent* next = PeekScheduled();
+        if (next == nullptr || next->time >= until) {
+            return false;
+        }
+        return sequencer_events.pop(out);
+    }
+
+    // Audio thread: the next pending sequencer event, or nullptr.
+    const Sequencing::NoteEvent* PeekScheduled() {
+        // Load the epoch after the event, seeing an event means seeing the flush it was stamped after
+        const Sequencing::NoteEvent* next = sequencer_events.front();
+        while (next != nullptr && next->epoch != event_epoch.load(std::memory_order_acquire)) {
+            Sequencing::NoteEvent dropped{};
+            sequencer_events.pop(dropped);
+            next = sequencer_events.front();
+        }
+        return next;
+    }
+private:
+    std::atomic<uint32_t> event_epoch = 0;
+    SpscQueue<Sequencing::NoteEvent, 1024> sequencer_events;
+    MpscQueue<Sequencing::NoteEvent, 256> live_events; // Every MIDI input port calls back on its own thread
+    midi::EventBuffer block_events;
+    midi::EventBuffer live_waiting[2];
+    size_t live_parity = 0;
 };
 
 } // audio
@@ -1,131 +1,151 @@
 #include "WaveformGenerator.h"
 
 #include <algorithm>
+#include <limits>
 #include <math.h>
 
 #include "audio/AudioBackend.h"
 #include "audio/audio_math.h"
+#include "audio/tuning/Tuning.h"
+#include "WaveformKernels.h"
+#include "audio/dsp/DspKernels.h"
 
 namespace audio::Generators {
-    void WaveformGenerator::ProcessScheduledNoteOns(uint64_t sample_index, int read_idx) {
-        auto& scheduled_on = scheduled_note_buffer_on[read_idx];
-        if (!scheduled_on.empty()) {
-            for (auto& note : scheduled_on) {
-                int note_number = (note.note_number);
-                int velocity = note.velocity;
-                float frequency = audio::piano::midi_to_frequency(note_number);
-                float amplitude = static_cast<float>(velocity) / 127.0f; // Normalize velocity to [0, 1]
-
-                const float detune = 0.5f; // Detune in semitones
-                for (int i = 0; i < unison; ++i) {
-                    Sequencing::Voice voice{};
-                    float detune_cents = (i - (unison - 1) / 2.0f) * detune; // detune in cents
-                    float detune_ratio = std::pow(2.0f, detune_cents / 1200.0f); // convert cents to frequency ratio
-                    voice.frequency = frequency * detune_ratio;
-
-                    voice.amplitude = amplitude / static_cast<float>(unison); // normalize amplitude to prevent volume overload
-
-                    // Pan across stereo field for each unison voice
-                    if (unison > 1) {
-                        voice.pan = (i / static_cast<float>(unison - 1)) * 2.0f - 1.0f; // spread from -1.0 (L) to +1.0 (R)
-                    } else {
-                        voice.pan = 0.0f;
-                    }
-
-                    // Optional phase randomization
-                    if (phase_randomization > 0.0f) {
-                        float random_phase = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * phase_randomization;
-                        voice.phase = random_phase;
-                    } else {
-                        voice.phase = 0.0f;
-                    }
-
-                    voice.id = static_cast<int>(note_number);
-                    voice.creation_time = sample_index;
-
-                    voice.envelope.attackTime = static_cast<uint64_t>(attack * SAMPLE_RATE);
-                    voice.envelope.attackTension = 0.5f;
-                    voice.envelope.decayTime = static_cast<uint64_t>(decay * SAMPLE_RATE);
-                    voice.envelope.decayTension = 0.5f;
-                    voice.envelope.sustainLevel = sustain;
-                    voice.envelope.releaseTime = static_cast<uint64_t>(release * SAMPLE_RATE);
-                    voice.envelope.releaseTension = 0.5f;
-
-                    this->voices.push_back(voice);
-                }
-            }
-            scheduled_on.clear(); // Clear scheduled notes after processing
+    Sequencing::Voice& WaveformGenerator::AllocateVoice(uint64_t sample_index) {
+        if (voices.size() < max_voices) {
+            return voices.emplace_back();
         }
-    }
-
-    void WaveformGenerator::ProcessScheduledNoteOffs(uint64_t sample_index, int read_idx) {
-        auto& scheduled_off = scheduled_note_buffer_off[read_idx];
-        if (!scheduled_off.empty()) {
-            for (auto& note_off : scheduled_off) {
-                int note = note_off.note_number;
-
-                for (auto& voice : this->voices) {
-                    if (voice.id == note) {
-                        voice.envelope.state = Sequencing::AdsrState::Release; // Set envelope to release state
-                        voice.creation_time = sample_index; // Update creation time to current sample index
-
-                        voice.envelope.enterRelease(sample_index);
-                    }
-                }
+        // Pool is full, take over the voice that is least audible right now (usually one deep in its release).
+        // Voices started on this very sample have not rendered yet, they only look silent.
+        const auto loudness = [sample_index](const Sequencing::Voice& voice) {
+            if (voice.creation_time == sample_index && voice.envelope.state == Sequencing::AdsrState::Attack) {
+                return std::numeric_limits<float>::max();
             }
-            scheduled_off.clear();
-        }
+            return voice.envelope.currentAmplitude * voice.amplitude;
+        };
+        auto quietest = std::min_element(voices.begin(), voices.end(), [&](const Sequencing::Voice& a, const Sequencing::Voice& b) {
+            return loudness(a) < loudness(b);
+        });
+        *quietest = Sequencing::Voice{};
+        return *quietest;
     }
 
-    void WaveformGenerator::Process(float *buffer, int channels, int buffer_size, uint64_t current_sample) {
-        const float two_pi = 2.0f * float(M_PI);
-        const float sample_rate_inv = 1.0f / SAMPLE_RATE;
-
-        int read_idx = write_buffer_index.exchange(1 - write_buffer_index); // atomically swap
+    void WaveformGenerator::StartNote(int note_number, int velocity, uint64_t sample_index) {
+        float frequency = audio::tuning::frequency(note_number);
+        if (frequency <= 0.0f) {
+            return; // Unmapped in the active tuning
+        }
+        float amplitude = static_cast<float>(velocity) / 127.0f; // Normalize velocity to [0, 1]
+
+        const float detune = 0.5f; // Detune in semitones
+        for (int i = 0; i < unison; ++i) {
+            Sequencing::Voice& voice = AllocateVoice(sample_index);
+            float detune_cents = (i - (unison - 1) / 2.0f) * detune; // detune in cents
+            float detune_ratio = audio::math::fast::cents_to_ratio(detune_cents); // convert cents to frequency ratio
+            voice.frequency = frequency * detune_ratio;
+
+            voice.amplitude = amplitude / static_cast<float>(unison); // normalize amplitude to prevent volume overload
+
+            // Pan across stereo field for each unison voice
+            if (unison > 1) {
+                voice.pan = (i / static_cast<float>(unison - 1)) * 2.0f - 1.0f; // spread from -1.0 (L) to +1.0 (R)
+            } else {
+                voice.pan = 0.0f;
+            }
 
-        ProcessScheduledNoteOns(current_sample, read_idx);
-        ProcessScheduledNoteOffs(current_sample, read_idx);
+            // Every voice gets its own stream, keyed so offline renders of the same song are identical
+            uint32_t voice_seed = math::rng::combine(math::rng::combine(seed, static_cast<uint32_t>(note_number)), static_cast<uint32_t>(i));
+            voice_seed = math::rng::combine(voice_seed, static_cast<uint32_t>(sample_index));
+            voice.noise.seed = voice_seed;
+
+            // Optional phase randomization
+            if (phase_randomization > 0.0f) {
+                float random_phase = math::rng::unit(math::rng::combine(voice_seed, 1), 0) * phase_randomization;
+                voice.phase = random_phase;
+            } else {
+                voice.phase = 0.0f;
+            }
 
-        std::vector<Sequencing::Voice*> to_remove;
+            voice.id = static_cast<int>(note_number);
+            voice.creation_time = sample_index;
 
-        for (int f = 0; f < buffer_size; ++f) {
-            uint64_t sample_index = current_sample + f;
+            voice.envelope.attackTime = static_cast<uint64_t>(attack * SAMPLE_RATE);
+            voice.envelope.attackTension = 0.5f;
+            voice.envelope.decayTime = static_cast<uint64_t>(decay * SAMPLE_RATE);
+            voice.envelope.decayTension = 0.5f;
+            voice.envelope.sustainLevel = sustain;
+            voice.envelope.releaseTime = static_cast<uint64_t>(release * SAMPLE_RATE);
+            voice.envelope.releaseTension = 0.5f;
+        }
+    }
 
-            for (auto& voice : this->voices) {
-                const float phaseInc = two_pi * voice.frequency / SAMPLE_RATE;
-                voice.phase += phaseInc;
-                if (voice.phase >= two_pi) voice.phase -= two_pi;
-                float s = audio::math::generate_waveform(waveform, voice.phase) * voice.amplitude * volume;
-                int idx = f * channels;
+    void WaveformGenerator::ReleaseNote(int note, uint64_t sample_index) {
+        for (auto& voice : this->voices) {
+            if (voice.id == note && voice.envelope.state != Sequencing::AdsrState::Release) {
+                voice.envelope.state = Sequencing::AdsrState::Release; // Set envelope to release state
+                voice.creation_time = sample_index; // Update creation time to current sample index
 
-                bool to_delete = false; // This is to avoid unused variable warnings
-                float gh = voice.envelope.process(sample_index, voice.creation_time, &to_delete);
-                s *= gh; // Apply envelope to the sample
+                voice.envelope.enterRelease(sample_index);
+            }
+        }
+    }
 
-                std::array sample = {s, s};
+    void WaveformGenerator::RenderVoices(kernels::RenderVoiceFn render, const kernels::BlockParams& params) {
+        // Render every voice, compacting out the ones that finished their release
+        size_t alive = 0;
+        for (size_t i = 0; i < voices.size(); ++i) {
+            if (render(voices[i], params)) {
+                continue;
+            }
+            if (alive != i) {
+                voices[alive] = voices[i];
+            }
+            ++alive;
+        }
+        voices.erase(voices.begin() + static_cast<std::ptrdiff_t>(alive), voices.end());
+    }
 
-                std::array<float, 2> panned = audio::math::pan(sample, voice.pan);
-                std::array<float, 2> panned_master = audio::math::pan(panned, pan); // Use the generator's pan
-                buffer[idx] += panned_master[0];
-                if (channels > 1)
-                    buffer[idx + 1] += panned_master[1];
+    void WaveformGenerator::Process(float *buffer, int channels, int buffer_size, uint64_t current_sample) {
+        // Live input and sequencer events for the whole block, after the note effects
+        const midi::EventBuffer& events = CollectEvents(current_sample, buffer_size);
+        const auto changes = parameters.collect(current_sample, current_sample + static_cast<uint64_t>(buffer_size));
+
+        // The waveform and channel count are fixed for the block, so resolve the kernel once up front
+        const kernels::RenderVoiceFn render = dsp::kernels().oscillator(waveform, channels);
+
+        // Events and parameter changes are applied on their exact sample, rendering in segments between them
+        int offset = 0;
+        size_t next = 0;
+        size_t next_change = 0;
+        while (offset < buffer_size) {
+            const uint64_t now = current_sample + static_cast<uint64_t>(offset);
+
+            for (; next_change < changes.size() && changes[next_change].time <= now; ++next_change) {
+                parameters.apply(changes[next_change]);
+            }
 
-                if (to_delete) {
-                    to_remove.push_back(&voice); // Mark voice for removal
+            for (; next < events.size() && events[next].time <= now; ++next) {
+                if (events[next].type == Sequencing::EventType::NoteOn) {
+                    StartNote(events[next].note, events[next].velocity, now);
+                } else {
+                    ReleaseNote(events[next].note, now);
                 }
             }
-        }
 
-        // Remove voices marked for deletion
-        if (!to_remove.empty()) {
-            voices.erase(
-                std::remove_if(voices.begin(), voices.end(),
-                    [&to_remove](const Sequencing::Voice& v) {
-                        return std::any_of(to_remove.begin(), to_remove.end(),
-                                           [&v](const Sequencing::Voice* ptr) { return ptr == &v; });
-                    }),
-                voices.end()
-            );
+            int end = buffer_size;
+            if (next < events.size()) {
+                end = static_cast<int>(events[next].time - current_sample);
+            }
+            if (next_change < changes.size()) {
+                end = std::min(end, static_cast<int>(changes[next_change].time - current_sample));
+            }
+            if (parameters.ramping()) {
+                end = std::min(end, offset + static_cast<int>(ParameterStore::ramp_step));
+            }
+
+            RenderVoices(render, {buffer + offset * channels, channels, end - offset, now, volume, pan});
+            parameters.advance(static_cast<uint32_t>(end - offset));
+            offset = end;
         }
     }
 }
@@ -2,6 +2,7 @@
 #define WAVEFORMGENERATOR_H
 #include "audio/AudioGenerator.h"
 #include "audio/piano.h"
+#include "WaveformKernels.h"
 
 namespace audio::Generators {
 
@@ -14,15 +15,31 @@ public:
     float release = 1.f; // Release time in seconds
     int unison = 1;
     float phase_randomization = 0.0f; // Phase randomization in radians
+    uint32_t seed = 0x5eed; // Seed for noise and phase randomization, same seed and song give the same render
+
+    // Fixed voice pool, reserved up front so starting a note on the audio thread never allocates. When it is full
+    // the quietest voice is stolen.
+    static constexpr size_t max_voices = 256;
 
     WaveformGenerator()
-        : AudioGenerator("Waveform Generator"){}
+        : AudioGenerator("Waveform Generator") {
+        voices.reserve(max_voices);
+
+        // Envelope changes apply to the notes started after them
+        parameters.add("Attack", &attack, 0.01f, 10.0f);
+        parameters.add("Decay", &decay, 0.01f, 10.0f);
+        parameters.add("Sustain", &sustain, 0.0f, 1.0f);
+        parameters.add("Release", &release, 0.01f, 10.0f);
+        parameters.add("Phase Randomization", &phase_randomization, 0.0f, 6.2831853f);
+    }
 
     void Process(float *buffer, int channels, int buffer_size, uint64_t current_sample) override;
 
 private:
-    void ProcessScheduledNoteOns(uint64_t sample_index, int read_idx);
-    void ProcessScheduledNoteOffs(uint64_t sample_index, int read_idx);
+    void StartNote(int note_number, int velocity, uint64_t sample_index);
+    Sequencing::Voice& AllocateVoice(uint64_t sample_index);
+    void ReleaseNote(int note, uint64_t sample_index);
+    void RenderVoices(kernels::RenderVoiceFn render, const kernels::BlockParams& params);
 };
 
 }
@@ -0,0 +1,111 @@
+#ifndef WAVEFORMKERNELS_H
+#define WAVEFORMKERNELS_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "audio/AudioDefinitions.h"
+#include "audio/audio_math.h"
+#include "audio/Sequencing/Voice.h"
+
+namespace audio::Generators::kernels {
+
+    // Everything a kernel needs that is fixed for the whole block.
+    struct BlockParams {
+        float *buffer;
+        int channels; // Interleaved stride of the buffer
+        int buffer_size;
+        uint64_t current_sample;
+        float volume;
+        float pan; // Generator pan, applied on top of the voice pan
+    };
+
+    // Renders a single voice into the block, returns true once the voice has finished its release.
+    using RenderVoiceFn = bool (*)(Sequencing::Voice& voice, const BlockParams& params);
+
+    // Frames per pass, the phase, envelope and sample scratch arrays for one pass live on the stack.
+    constexpr int pass_frames = 64;
+
+    template <Waveform W, int Channels>
+    bool render_voice(Sequencing::Voice& voice, const BlockParams& params) {
+        const float phase_inc = audio::math::fast::two_pi * voice.frequency / SAMPLE_RATE;
+
+        // Both pan stages are constant for the block, so fold them into a single gain per channel.
+        const auto gains = audio::math::pan(audio::math::pan({voice.amplitude * params.volume, voice.amplitude * params.volume}, voice.pan), params.pan);
+
+        alignas(64) float phases[pass_frames];
+        alignas(64) float envelope[pass_frames];
+        alignas(64) float samples[pass_frames];
+
+        // Each pass is split into plain array loops: phase ramp, envelope, oscillator and mix. None of them branch
+        // per sample, the envelope's stage changes are handled between its ramps.
+        bool finished = false;
+        float phase = voice.phase;
+        for (int start = 0; start < params.buffer_size; start += pass_frames) {
+            const int n = std::min(pass_frames, params.buffer_size - start);
+
+            for (int i = 0; i < n; ++i) {
+                phases[i] = audio::math::fast::wrap_phase(phase + phase_inc * static_cast<float>(i + 1));
+            }
+            phase = phases[n - 1];
+
+            voice.envelope.render(envelope, n, params.current_sample + start, voice.creation_time, &finished);
+
+            if constexpr (W == Waveform::Noise) {
+                voice.noise.fill_bipolar(samples, n);
+            } else {
+                for (int i = 0; i < n; ++i) {
+                    samples[i] = audio::math::generate_waveform<W>(phases[i]);
+                }
+            }
+
+            float *out = params.buffer + start * params.channels;
+            for (int i = 0; i < n; ++i) {
+                const float s = samples[i] * envelope[i];
+                out[i * params.channels] += s * gains[0];
+                if constexpr (Channels > 1)
+                    out[i * params.channels + 1] += s * gains[1];
+            }
+        }
+        voice.phase = phase;
+        if constexpr (W != Waveform::Noise) {
+            // Keep the stream in step with the block even when it isn't drawn from
+            voice.noise.counter += static_cast<uint32_t>(params.buffer_size);
+        }
+
+        return finished;
+    }
+
+    // Mono gets its own kernel, wider buffers only receive the first two channels.
+    constexpr int channel_variants = 2;
+
+    using RenderVoiceTable = std::array<std::array<RenderVoiceFn, channel_variants>, waveform::all_waveforms.size()>;
+
+    namespace detail {
+        template <template <Waveform, int> class Variant, std::size_t... Ws>
+        constexpr RenderVoiceTable make_table(std::index_sequence<Ws...>) {
+            return RenderVoiceTable{{
+                {{ &Variant<static_cast<Waveform>(Ws), 1>::run, &Variant<static_cast<Waveform>(Ws), 2>::run }}...
+            }};
+        }
+    }
+
+    // Builds the [waveform][channels] dispatch table, Variant<W, Channels>::run wraps render_voice for one instruction set.
+    template <template <Waveform, int> class Variant>
+    constexpr RenderVoiceTable make_table() {
+        return detail::make_table<Variant>(std::make_index_sequence<waveform::all_waveforms.size()>{});
+    }
+
+    // Picks the kernel once per block, so the per-sample loop never branches on the waveform.
+    inline RenderVoiceFn select(const RenderVoiceTable& table, Waveform waveform, int channels) {
+        auto index = static_cast<std::size_t>(waveform);
+        if (index >= table.size()) {
+            index = 0;
+        }
+        return table[index][channels > 1 ? 1 : 0];
+    }
+}
+
+#endif //WAVEFORMKERNELS_H
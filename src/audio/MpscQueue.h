@@ -0,0 +1,78 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace audio {
+
+// Bounded multi producer / single consumer ring. Producers (UI, MIDI input) never block or allocate, a
+// slot's sequence number tells whether it is free, being written or ready to read.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Any thread, returns false when the queue is full.
+    bool push(const T& value) {
+        size_t position = write_index.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[position & (Capacity - 1)];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (difference == 0) {
+                // Free for this position, claim it
+                if (write_index.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false; // Still holds an element from the previous lap
+            } else {
+                position = write_index.load(std::memory_order_relaxed); // Another producer got there first
+            }
+        }
+    }
+
+    // Consumer side, returns false when the queue is empty.
+    bool pop(T& out) {
+        const size_t position = read_index.load(std::memory_order_relaxed);
+        Slot& slot = slots[position & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        out = slot.value;
+        slot.sequence.store(position + Capacity, std::memory_order_release);
+        read_index.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer side.
+    [[nodiscard]] bool empty() const {
+        const size_t position = read_index.load(std::memory_order_relaxed);
+        return slots[position & (Capacity - 1)].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value{};
+    };
+
+    alignas(64) std::atomic<size_t> read_index{0};
+    alignas(64) std::atomic<size_t> write_index{0};
+    std::array<Slot, Capacity> slots;
+};
+
+} // audio
+
+#endif //MPSCQUEUE_H
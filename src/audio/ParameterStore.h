@@ -0,0 +1,185 @@
+#ifndef PARAMETERSTORE_H
+#define PARAMETERSTORE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "MpscQueue.h"
+
+namespace audio {
+
+// A generator setting that can be changed while it plays. value points into the generator.
+struct Parameter {
+    const char* name;
+    float* value;
+    float min;
+    float max;
+    uint32_t ramp; // Samples a change glides over, 0 jumps straight to it
+};
+
+struct ParameterChange {
+    uint64_t time; // Output sample, 0 applies it at the start of the next block
+    uint16_t index;
+    float value;
+};
+
+// The automatable parameters of one generator. Any thread (MIDI input, UI) queues changes without locking,
+// the audio thread applies them at their sample between rendering segments, so a controller sweep lands
+// where it was played instead of once per block.
+class ParameterStore {
+public:
+    static constexpr size_t max_changes = 256; // Applied per block, more changes to one parameter are merged
+    static constexpr size_t max_parameters = 32;
+    static constexpr uint32_t ramp_step = 32; // Frames per rendering segment while a ramp is running
+
+    // Generator constructor only, the list is fixed once the generator runs. Parameters the render reads per
+    // segment (levels, pan) want a ramp of a few milliseconds, or a controller sweep steps audibly.
+    void add(const char* name, float* value, float min, float max, uint32_t ramp = 0) {
+        if (parameters.size() == max_parameters) {
+            throw std::length_error("Too many parameters on one generator");
+        }
+        latest[parameters.size()].store(*value, std::memory_order_relaxed);
+        parameters.push_back({name, value, min, max, ramp});
+        ramps.push_back({*value, 0.0f, 0});
+    }
+
+    [[nodiscard]] size_t size() const { return parameters.size(); }
+    [[nodiscard]] const Parameter& operator[](size_t index) const { return parameters[index]; }
+
+    // Index of the parameter called name, -1 when there is none.
+    [[nodiscard]] int find(std::string_view name) const {
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            if (name == parameters[i].name) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Any thread: the value is clamped to the parameter's range. False when the queue is full.
+    bool queue(uint16_t index, float value, uint64_t time = 0) {
+        if (index >= parameters.size()) {
+            return false;
+        }
+        value = std::clamp(value, parameters[index].min, parameters[index].max);
+        if (!changes.push({time, index, value})) {
+            return false;
+        }
+        latest[index].store(value, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Any thread: the value last queued, which the UI edits a copy of instead of the generator's own field.
+    [[nodiscard]] float get(size_t index) const {
+        return latest[index].load(std::memory_order_relaxed);
+    }
+
+    // Audio thread: the changes due before end, sorted, every time inside [start, end). Later ones wait for
+    // their block. Valid until the next call.
+    std::span<const ParameterChange> collect(uint64_t start, uint64_t end) {
+        due_count = 0;
+        std::array<ParameterChange, max_changes>& later = waiting[waiting_parity ^ 1];
+        size_t later_count = 0;
+
+        const auto place = [&](ParameterChange change) {
+            if (change.time >= end && later_count < max_changes) {
+                later[later_count++] = change;
+                return;
+            }
+            change.time = std::clamp(change.time, start, end - 1);
+            if (due_count < max_changes) {
+                due[due_count++] = change;
+                return;
+            }
+            // Out of room, the newest value of a parameter is the one that has to stick
+            for (size_t i = due_count; i-- > 0;) {
+                if (due[i].index == change.index) {
+                    due[i].value = change.value;
+                    return;
+                }
+            }
+        };
+
+        for (size_t i = 0; i < waiting_count; ++i) {
+            place(waiting[waiting_parity][i]);
+        }
+        ParameterChange change{};
+        while (changes.pop(change)) {
+            place(change);
+        }
+        waiting_parity ^= 1;
+        waiting_count = later_count;
+
+        std::stable_sort(due.begin(), due.begin() + static_cast<std::ptrdiff_t>(due_count), [](const ParameterChange& a, const ParameterChange& b) {
+            return a.time < b.time;
+        });
+        return {due.data(), due_count};
+    }
+
+    // Audio thread: a parameter with a ramp heads for the new value from wherever it is now.
+    void apply(const ParameterChange& change) {
+        const Parameter& parameter = parameters[change.index];
+        Ramp& ramp = ramps[change.index];
+        if (parameter.ramp == 0) {
+            *parameter.value = change.value;
+            ramp.remaining = 0;
+            return;
+        }
+        ramp.target = change.value;
+        ramp.step = (change.value - *parameter.value) / static_cast<float>(parameter.ramp);
+        ramp.remaining = parameter.ramp;
+        ramps_running = true;
+    }
+
+    // Audio thread: true while a ramp is running, the generator then renders in segments of ramp_step frames.
+    [[nodiscard]] bool ramping() const { return ramps_running; }
+
+    // Audio thread: moves the running ramps on by the frames just rendered.
+    void advance(uint32_t frames) {
+        if (!ramps_running) {
+            return;
+        }
+        ramps_running = false;
+        for (size_t i = 0; i < ramps.size(); ++i) {
+            Ramp& ramp = ramps[i];
+            if (ramp.remaining == 0) {
+                continue;
+            }
+            const uint32_t moved = std::min(frames, ramp.remaining);
+            ramp.remaining -= moved;
+            *parameters[i].value = ramp.remaining == 0 ? ramp.target : *parameters[i].value + ramp.step * static_cast<float>(moved);
+            ramps_running |= ramp.remaining > 0;
+        }
+    }
+
+private:
+    struct Ramp {
+        float target;
+        float step; // Per sample
+        uint32_t remaining;
+    };
+
+    std::vector<Parameter> parameters;
+    std::array<std::atomic<float>, max_parameters> latest{};
+    MpscQueue<ParameterChange, 1024> changes;
+
+    // Audio thread
+    std::array<ParameterChange, max_changes> due{};
+    size_t due_count = 0;
+    std::array<ParameterChange, max_changes> waiting[2]{};
+    size_t waiting_count = 0;
+    size_t waiting_parity = 0;
+    std::vector<Ramp> ramps; // Sized with parameters
+    bool ramps_running = false;
+};
+
+} // audio
+
+#endif //PARAMETERSTORE_H
@@ -0,0 +1,45 @@
+#include "Arrangement.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace audio {
+namespace Sequencing {
+    ArrangementIndex::ArrangementIndex(std::vector<Entry> input) : entries(std::move(input)) {
+        std::erase_if(entries, [](const Entry& e) { return e.instance.length == 0 || e.events == nullptr || e.events->empty(); });
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.instance.start < b.instance.start; });
+
+        if (entries.empty()) {
+            return;
+        }
+        leaves = std::bit_ceil(entries.size());
+        max_end.assign(2 * leaves, 0);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            max_end[leaves + i] = entries[i].instance.end();
+        }
+        for (size_t node = leaves - 1; node > 0; --node) {
+            max_end[node] = std::max(max_end[2 * node], max_end[2 * node + 1]);
+        }
+    }
+
+    void ArrangementIndex::overlapping(uint64_t from, uint64_t to, std::vector<uint32_t>& out) const {
+        if (!entries.empty() && from < to) {
+            query(1, 0, leaves, from, to, out);
+        }
+    }
+
+    void ArrangementIndex::query(size_t node, size_t first, size_t last, uint64_t from, uint64_t to, std::vector<uint32_t>& out) const {
+        // Nothing in this subtree ends after from, or everything in it starts at to or later
+        if (first >= entries.size() || max_end[node] <= from || entries[first].instance.start >= to) {
+            return;
+        }
+        if (node >= leaves) {
+            out.push_back(static_cast<uint32_t>(first));
+            return;
+        }
+        const size_t middle = first + (last - first) / 2;
+        query(2 * node, first, middle, from, to, out);
+        query(2 * node + 1, middle, last, from, to, out);
+    }
+} // Sequencing
+} // audio
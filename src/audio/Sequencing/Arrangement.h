@@ -0,0 +1,62 @@
+#ifndef ARRANGEMENT_H
+#define ARRANGEMENT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "EventTimeline.h"
+
+namespace audio {
+namespace Sequencing {
+
+// One placement of a pattern in the song. Plays the pattern's ticks [offset, offset + length) at song
+// ticks [start, start + length), notes still held at the end are cut there.
+struct PatternInstance {
+    int pattern_id;
+    uint64_t start = 0;
+    uint64_t length = 0;
+    uint64_t offset = 0;
+
+    [[nodiscard]] uint64_t end() const { return start + length; }
+    [[nodiscard]] uint64_t to_song(uint64_t pattern_tick) const { return start + (pattern_tick - offset); }
+    [[nodiscard]] uint64_t to_pattern(uint64_t song_tick) const { return offset + (song_tick - start); }
+};
+
+// The pattern instances of a song, edited from the UI under SequencerState::lock_patterns().
+class Arrangement {
+public:
+    std::vector<PatternInstance> instances;
+};
+
+// Interval index over the instances, built by the timeline compiler. Every instance points at its pattern's
+// compiled events, so a pattern reused hundreds of times still has its notes compiled only once.
+class ArrangementIndex {
+public:
+    struct Entry {
+        PatternInstance instance;
+        const EventTimeline* events;
+    };
+
+    ArrangementIndex() = default;
+    // Entries with zero length or without events are dropped.
+    explicit ArrangementIndex(std::vector<Entry> entries);
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+    [[nodiscard]] const Entry& operator[](size_t i) const { return entries[i]; }
+
+    // Appends the indices of all entries overlapping song ticks [from, to) to out, in start order.
+    // O((k + 1) log n) for k results.
+    void overlapping(uint64_t from, uint64_t to, std::vector<uint32_t>& out) const;
+
+private:
+    std::vector<Entry> entries; // Sorted by start
+    std::vector<uint64_t> max_end; // Implicit segment tree over entries, latest end in every subtree
+    size_t leaves = 0;
+
+    void query(size_t node, size_t first, size_t last, uint64_t from, uint64_t to, std::vector<uint32_t>& out) const;
+};
+
+} // Sequencing
+} // audio
+
+#endif //ARRANGEMENT_H
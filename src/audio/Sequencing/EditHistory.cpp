@@ -0,0 +1,40 @@
+#include "EditHistory.h"
+
+#include <utility>
+
+namespace audio {
+namespace Sequencing {
+    void EditHistory::record(Snapshot before) {
+        undo_steps.push_back(std::move(before));
+        if (undo_steps.size() > max_depth) {
+            undo_steps.pop_front();
+        }
+        redo_steps.clear();
+    }
+
+    bool EditHistory::undo(Snapshot& current) {
+        if (undo_steps.empty()) {
+            return false;
+        }
+        redo_steps.push_back(std::move(current));
+        current = std::move(undo_steps.back());
+        undo_steps.pop_back();
+        return true;
+    }
+
+    bool EditHistory::redo(Snapshot& current) {
+        if (redo_steps.empty()) {
+            return false;
+        }
+        undo_steps.push_back(std::move(current));
+        current = std::move(redo_steps.back());
+        redo_steps.pop_back();
+        return true;
+    }
+
+    void EditHistory::clear() {
+        undo_steps.clear();
+        redo_steps.clear();
+    }
+} // Sequencing
+} // audio
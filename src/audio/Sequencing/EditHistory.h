@@ -0,0 +1,47 @@
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "Arrangement.h"
+#include "Pattern.h"
+
+namespace audio {
+namespace Sequencing {
+
+// Undo and redo steps of the song. A step is a full copy of the patterns and the arrangement, but the
+// copies share their note chunks (see NoteStorage) with the song and with each other, so a step costs
+// the chunk pointers plus the chunks edited after it was taken, however deep the history gets.
+class EditHistory {
+public:
+    struct Snapshot {
+        std::vector<Pattern> patterns;
+        Arrangement arrangement;
+    };
+
+    // Oldest steps are dropped beyond this many
+    static constexpr size_t max_depth = 512;
+
+    // Stores the state from before an edit and forgets everything that could be redone.
+    void record(Snapshot before);
+
+    // Swap current for the step before (after) it, false when there is none.
+    bool undo(Snapshot& current);
+    bool redo(Snapshot& current);
+
+    [[nodiscard]] bool can_undo() const { return !undo_steps.empty(); }
+    [[nodiscard]] bool can_redo() const { return !redo_steps.empty(); }
+
+    void clear();
+
+private:
+    std::deque<Snapshot> undo_steps;
+    std::vector<Snapshot> redo_steps;
+};
+
+} // Sequencing
+} // audio
+
+#endif //EDITHISTORY_H
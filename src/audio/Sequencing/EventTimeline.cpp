@@ -0,0 +1,227 @@
+#include "EventTimeline.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace audio {
+namespace Sequencing {
+    namespace {
+        struct CompiledEvent {
+            uint32_t tick;
+            EventType type;
+            uint8_t note;
+            uint8_t velocity;
+            uint16_t generator;
+            uint32_t stop_tick;
+            uint8_t chance;
+        };
+
+        bool before(const CompiledEvent& a, const CompiledEvent& b) {
+            if (a.tick != b.tick) {
+                return a.tick < b.tick;
+            }
+            return a.type < b.type;
+        }
+
+        uint16_t generator_index(std::vector<AudioGenerator*>& table, AudioGenerator* generator) {
+            auto it = std::find(table.begin(), table.end(), generator);
+            if (it != table.end()) {
+                return static_cast<uint16_t>(it - table.begin());
+            }
+            table.push_back(generator);
+            return static_cast<uint16_t>(table.size() - 1);
+        }
+
+        // One sorted run of note ons and one of note offs per sequence, with the groove already applied
+        void build_runs(const NoteSequence& sequence, const Groove& groove, uint16_t generator, std::vector<std::vector<CompiledEvent>>& runs) {
+            std::vector<CompiledEvent> ons;
+            std::vector<CompiledEvent> offs;
+            ons.reserve(sequence.notes.size());
+            offs.reserve(sequence.notes.size());
+
+            for (const auto& note : sequence.notes) {
+                if (note.length == 0 || note.is_muted()) {
+                    continue; // Zero length notes never sound
+                }
+                const auto pitch = std::min<uint8_t>(note.pitch, 127);
+                const uint32_t start = groove.apply_tick(note.tick);
+                const auto stop = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(start) + note.length, UINT32_MAX));
+                const auto velocity = std::min<uint8_t>(groove.apply_velocity(note.tick, note.velocity), 127);
+                ons.push_back({start, EventType::NoteOn, pitch, velocity, generator, stop, 100});
+                offs.push_back({stop, EventType::NoteOff, pitch, 0, generator, 0, 100});
+            }
+
+            // Sequences are kept sorted by tick already (a groove can reorder nearby notes), stop ticks need their own sort
+            if (!std::is_sorted(ons.begin(), ons.end(), before)) {
+                std::stable_sort(ons.begin(), ons.end(), before);
+            }
+            std::stable_sort(offs.begin(), offs.end(), before);
+
+            if (!ons.empty()) {
+                runs.push_back(std::move(ons));
+                runs.push_back(std::move(offs));
+            }
+        }
+
+        // Same for a step grid, every hit of every ratchet goes straight into the runs
+        void build_step_runs(const StepSequence& sequence, const Groove& groove, uint16_t generator, std::vector<std::vector<CompiledEvent>>& runs) {
+            std::vector<CompiledEvent> ons;
+            std::vector<CompiledEvent> offs;
+
+            // Step major, so the ons come out (nearly) in order
+            for (size_t s = 0; s < sequence.step_count(); ++s) {
+                const auto step_tick = static_cast<uint32_t>(std::min<uint64_t>(s * sequence.step_ticks, UINT32_MAX));
+                for (const auto& lane : sequence.lanes) {
+                    if (s >= lane.steps.size() || !lane.steps[s].is_active()) {
+                        continue;
+                    }
+                    const Step& step = lane.steps[s];
+                    const auto pitch = std::min<uint8_t>(lane.pitch, 127);
+                    const uint32_t start = groove.apply_tick(step_tick);
+                    const auto velocity = std::min<uint8_t>(groove.apply_velocity(step_tick, step.velocity), 127);
+                    const uint32_t length = sequence.hit_length(step.ratchet);
+                    for (uint32_t r = 0; r < step.ratchet; ++r) {
+                        const uint64_t on = start + static_cast<uint64_t>(r) * sequence.step_ticks / step.ratchet;
+                        const auto on_tick = static_cast<uint32_t>(std::min<uint64_t>(on, UINT32_MAX));
+                        const auto stop = static_cast<uint32_t>(std::min<uint64_t>(on + length, UINT32_MAX));
+                        ons.push_back({on_tick, EventType::NoteOn, pitch, velocity, generator, stop, std::min<uint8_t>(step.probability, 100)});
+                        offs.push_back({stop, EventType::NoteOff, pitch, 0, generator, 0, 100});
+                    }
+                }
+            }
+
+            if (!std::is_sorted(ons.begin(), ons.end(), before)) {
+                std::stable_sort(ons.begin(), ons.end(), before);
+            }
+            std::stable_sort(offs.begin(), offs.end(), before);
+
+            if (!ons.empty()) {
+                runs.push_back(std::move(ons));
+                runs.push_back(std::move(offs));
+            }
+        }
+    }
+
+    size_t EventTimeline::lower_bound(uint64_t tick) const {
+        return static_cast<size_t>(std::lower_bound(ticks.begin(), ticks.end(), tick) - ticks.begin());
+    }
+
+    void EventTimeline::sounding_at(uint64_t tick, std::vector<uint32_t>& out) const {
+        out.clear();
+        const size_t end = lower_bound(tick);
+
+        // Every note held at tick that started before the checkpoint is in the checkpoint's list: tick is
+        // past the event before the checkpoint, so the note was still held there too
+        size_t first = 0;
+        if (chase_offsets.size() > 1) {
+            const size_t checkpoint = std::min(end / chase_interval, chase_offsets.size() - 2);
+            first = checkpoint * chase_interval;
+            for (uint32_t k = chase_offsets[checkpoint]; k < chase_offsets[checkpoint + 1]; ++k) {
+                if (stop_ticks[chase_events[k]] > tick) {
+                    out.push_back(chase_events[k]);
+                }
+            }
+        }
+
+        for (size_t i = first; i < end; ++i) {
+            if (types[i] == EventType::NoteOn && stop_ticks[i] > tick) {
+                out.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    void EventTimeline::build_chase_index() {
+        chase_offsets.clear();
+        chase_events.clear();
+
+        std::vector<uint32_t> held;
+        for (size_t i = 0; i < ticks.size(); ++i) {
+            if (i % chase_interval == 0) {
+                if (i > 0) {
+                    const uint64_t last = ticks[i - 1];
+                    std::erase_if(held, [&](uint32_t on) { return stop_ticks[on] <= last; });
+                }
+                chase_offsets.push_back(static_cast<uint32_t>(chase_events.size()));
+                chase_events.insert(chase_events.end(), held.begin(), held.end());
+            }
+            if (types[i] == EventType::NoteOn) {
+                held.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        chase_offsets.push_back(static_cast<uint32_t>(chase_events.size()));
+    }
+
+    void EventTimeline::reserve(size_t count) {
+        ticks.reserve(count);
+        generators.reserve(count);
+        types.reserve(count);
+        notes.reserve(count);
+        velocities.reserve(count);
+        stop_ticks.reserve(count);
+        chances.reserve(count);
+    }
+
+    void EventTimeline::push(uint32_t tick, uint16_t generator, EventType type, uint8_t note, uint8_t velocity, uint32_t stop_tick, uint8_t chance) {
+        ticks.push_back(tick);
+        generators.push_back(generator);
+        types.push_back(type);
+        notes.push_back(note);
+        velocities.push_back(velocity);
+        stop_ticks.push_back(stop_tick);
+        chances.push_back(chance);
+    }
+
+    EventTimeline EventTimeline::compile(const Pattern& pattern) {
+        EventTimeline timeline;
+
+        std::vector<std::vector<CompiledEvent>> runs;
+        for (const auto& sequence : pattern.note_sequences) {
+            if (sequence.generator == nullptr) {
+                continue;
+            }
+            build_runs(sequence, pattern.groove, generator_index(timeline.generator_table, sequence.generator), runs);
+        }
+        for (const auto& sequence : pattern.step_sequences) {
+            if (sequence.generator == nullptr) {
+                continue;
+            }
+            build_step_runs(sequence, pattern.groove, generator_index(timeline.generator_table, sequence.generator), runs);
+        }
+
+        size_t total = 0;
+        for (const auto& run : runs) {
+            total += run.size();
+        }
+        timeline.reserve(total);
+
+        // K-way merge, the heap holds the head of every run (std heaps are max-heaps, so compare inverted)
+        std::vector<size_t> positions(runs.size(), 0);
+        std::vector<size_t> heap(runs.size());
+        std::iota(heap.begin(), heap.end(), 0);
+        auto later = [&](size_t a, size_t b) {
+            const auto& ea = runs[a][positions[a]];
+            const auto& eb = runs[b][positions[b]];
+            if (before(eb, ea)) return true;
+            if (before(ea, eb)) return false;
+            return a > b; // Stable across runs
+        };
+        std::make_heap(heap.begin(), heap.end(), later);
+
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            size_t run = heap.back();
+            const auto& event = runs[run][positions[run]];
+            timeline.push(event.tick, event.generator, event.type, event.note, event.velocity, event.stop_tick, event.chance);
+
+            if (++positions[run] < runs[run].size()) {
+                std::push_heap(heap.begin(), heap.end(), later);
+            } else {
+                heap.pop_back();
+            }
+        }
+
+        timeline.build_chase_index();
+        return timeline;
+    }
+} // Sequencing
+} // audio
@@ -0,0 +1,61 @@
+#ifndef EVENTTIMELINE_H
+#define EVENTTIMELINE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "NoteEvent.h"
+#include "Pattern.h"
+
+namespace audio {
+namespace Sequencing {
+
+// Every note event of one pattern in a flat, time sorted list. Stored as parallel arrays so the
+// playback scan only walks the ticks until something is due. Times are pattern ticks, the arrangement
+// places them in the song and the sequencer maps them to samples through the TempoMap.
+class EventTimeline {
+public:
+    std::vector<uint32_t> ticks; // Pattern ticks fit in 32 bits like the notes they come from
+    std::vector<uint16_t> generators; // Index into generator_table
+    std::vector<EventType> types;
+    std::vector<uint8_t> notes;
+    std::vector<uint8_t> velocities;
+    std::vector<uint32_t> stop_ticks; // For NoteOn events, when the matching NoteOff is due
+    std::vector<uint8_t> chances; // For NoteOn events, percent chance to play, rolled by the sequencer each time
+
+    std::vector<AudioGenerator*> generator_table;
+
+    [[nodiscard]] size_t size() const { return ticks.size(); }
+    [[nodiscard]] bool empty() const { return ticks.empty(); }
+    // Tick of the last event, the last NoteOff since they sort last.
+    [[nodiscard]] uint32_t end_tick() const { return ticks.empty() ? 0 : ticks.back(); }
+
+    // Index of the first event at or after tick.
+    [[nodiscard]] size_t lower_bound(uint64_t tick) const;
+
+    // Fills out with the NoteOn events that started before tick and are still held at it (the notes a
+    // playback starting there has to chase), in timeline order. Starts from the nearest checkpoint, so the
+    // cost is bounded by chase_interval plus the number of held notes, not by the position.
+    void sounding_at(uint64_t tick, std::vector<uint32_t>& out) const;
+
+    // Flattens one pattern with a k-way merge of its per-sequence note-on and note-off runs, applying its groove.
+    // Step sequences are rendered into runs of their own.
+    static EventTimeline compile(const Pattern& pattern);
+
+private:
+    static constexpr size_t chase_interval = 256; // Events between two chase checkpoints
+
+    // Checkpoint k sits at event k * chase_interval and lists the NoteOns before it that are still held after
+    // the event just before it, stored as ranges chase_offsets[k]..chase_offsets[k + 1] of chase_events.
+    std::vector<uint32_t> chase_offsets;
+    std::vector<uint32_t> chase_events;
+
+    void reserve(size_t count);
+    void push(uint32_t tick, uint16_t generator, EventType type, uint8_t note, uint8_t velocity, uint32_t stop_tick, uint8_t chance);
+    void build_chase_index();
+};
+
+} // Sequencing
+} // audio
+
+#endif //EVENTTIMELINE_H
@@ -0,0 +1,67 @@
+#include "Groove.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+namespace Sequencing {
+    Groove Groove::swing(float percent, uint32_t step_ticks) {
+        Groove groove;
+        groove.step_ticks = step_ticks;
+        // The first step of each pair takes percent of the pair, the second starts that much later
+        const float ratio = std::clamp(percent, 50.0f, 90.0f) / 100.0f;
+        groove.timing = {0, static_cast<int32_t>(std::lround((2.0f * ratio - 1.0f) * static_cast<float>(step_ticks)))};
+        return groove;
+    }
+
+    Groove Groove::extract(const NoteSequence& sequence, uint32_t steps, uint32_t step_ticks) {
+        Groove groove;
+        groove.step_ticks = step_ticks;
+        if (steps == 0 || step_ticks == 0 || sequence.notes.empty()) {
+            return groove;
+        }
+
+        std::vector<int64_t> offsets(steps, 0);
+        std::vector<int64_t> velocities(steps, 0);
+        std::vector<uint32_t> counts(steps, 0);
+        int64_t total_velocity = 0;
+        for (const auto& note : sequence.notes) {
+            const uint64_t step = groove.step_at(note.tick);
+            const auto slot = static_cast<size_t>(step % steps);
+            offsets[slot] += static_cast<int64_t>(note.tick) - static_cast<int64_t>(step * step_ticks);
+            velocities[slot] += note.velocity;
+            total_velocity += note.velocity;
+            ++counts[slot];
+        }
+
+        const int64_t mean_velocity = total_velocity / static_cast<int64_t>(sequence.notes.size());
+        groove.timing.resize(steps, 0);
+        groove.velocity.resize(steps, 0);
+        for (size_t i = 0; i < steps; ++i) {
+            if (counts[i] > 0) {
+                groove.timing[i] = static_cast<int32_t>(offsets[i] / counts[i]);
+                groove.velocity[i] = static_cast<int16_t>(velocities[i] / counts[i] - mean_velocity);
+            }
+        }
+        return groove;
+    }
+
+    uint32_t Groove::apply_tick(uint32_t tick) const {
+        if (is_straight() || timing.empty()) {
+            return tick;
+        }
+        const int32_t offset = timing[step_at(tick) % timing.size()];
+        const auto shifted = static_cast<int64_t>(tick) + std::lround(static_cast<float>(offset) * amount);
+        return static_cast<uint32_t>(std::clamp<int64_t>(shifted, 0, UINT32_MAX));
+    }
+
+    uint8_t Groove::apply_velocity(uint32_t tick, uint8_t note_velocity) const {
+        if (is_straight() || velocity.empty()) {
+            return note_velocity;
+        }
+        const int16_t offset = velocity[step_at(tick) % velocity.size()];
+        const auto changed = static_cast<long>(note_velocity) + std::lround(static_cast<float>(offset) * amount);
+        return static_cast<uint8_t>(std::clamp<long>(changed, 1, 127));
+    }
+} // Sequencing
+} // audio
@@ -0,0 +1,48 @@
+#ifndef GROOVE_H
+#define GROOVE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "NoteSequence.h"
+#include "TempoMap.h"
+
+namespace audio {
+namespace Sequencing {
+
+// Timing and velocity template over a grid of steps, repeating every timing.size() steps. Applied to a
+// pattern's notes when its timeline is compiled, the stored notes stay on the grid and playback of a
+// grooved pattern costs the same as a straight one.
+struct Groove {
+    uint32_t step_ticks = TempoMap::ticks_per_quarter / 4; // 16ths by default
+    std::vector<int32_t> timing; // Per step offset in ticks
+    std::vector<int16_t> velocity; // Per step offset, added to the note's velocity
+    float amount = 1.0f; // 0 is straight, 1 applies the template fully
+
+    // Delays every second step. 50% is straight, 66% a triplet feel, 75% a dotted one.
+    static Groove swing(float percent, uint32_t step_ticks = TempoMap::ticks_per_quarter / 4);
+
+    // Averages how far the notes fall from the grid (and how loud they are) per step, e.g. from a
+    // recorded or imported MIDI performance.
+    static Groove extract(const NoteSequence& sequence, uint32_t steps, uint32_t step_ticks = TempoMap::ticks_per_quarter / 4);
+
+    [[nodiscard]] bool is_straight() const {
+        return step_ticks == 0 || amount == 0.0f || (timing.empty() && velocity.empty());
+    }
+
+    // The note's start and velocity with the step nearest to it applied, length is kept.
+    [[nodiscard]] uint32_t apply_tick(uint32_t tick) const;
+    [[nodiscard]] uint8_t apply_velocity(uint32_t tick, uint8_t note_velocity) const;
+
+    bool operator==(const Groove& other) const = default;
+
+private:
+    [[nodiscard]] uint64_t step_at(uint32_t tick) const {
+        return (static_cast<uint64_t>(tick) + step_ticks / 2) / step_ticks;
+    }
+};
+
+} // Sequencing
+} // audio
+
+#endif //GROOVE_H
@@ -1,20 +1,35 @@
 #ifndef NOTE_H
 #define NOTE_H
 
+#include <algorithm>
 #include <cstdint>
 
 namespace audio::Sequencing {
+    namespace note_flags {
+        constexpr uint8_t muted = 1 << 0; // Skipped when the pattern is compiled
+        constexpr uint8_t selected = 1 << 1; // Editor state, ignored by playback
+    }
+
+    // Stored note, 12 bytes so sequences with millions of notes stay small and scan fast.
+    // Only what the note is lives here, playback state is kept by the sequencer.
     struct Note {
-        int note_number;
-        int velocity; // 0-127
+        uint32_t tick = 0; // Start, in pattern ticks (see TempoMap)
+        uint32_t length = 0; // In ticks, zero length notes never sound
+        uint8_t pitch = 60; // MIDI note number
+        uint8_t velocity = 100; // 0-127
+        int8_t pan = 0; // -127 (left) to 127 (right)
+        uint8_t flags = 0; // note_flags
 
-        float pan = 0.0f;
+        [[nodiscard]] uint64_t end() const { return static_cast<uint64_t>(tick) + length; }
+        [[nodiscard]] bool is_muted() const { return flags & note_flags::muted; }
+        [[nodiscard]] float pan_amount() const { return static_cast<float>(pan) / 127.0f; }
 
-        // Below is to be used by the sequencer:
-        uint64_t play_time = 0; // When the note should be played
-        uint64_t stop_time = 0; // When the note should be stopped
-        bool is_playing = false; // Whether the note is currently playing
+        static constexpr int8_t to_pan(float amount) {
+            return static_cast<int8_t>(std::clamp(amount, -1.0f, 1.0f) * 127.0f);
+        }
     };
+
+    static_assert(sizeof(Note) == 12);
 }
 
 #endif //NOTE_H
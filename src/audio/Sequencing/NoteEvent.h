@@ -0,0 +1,22 @@
+#ifndef NOTEEVENT_H
+#define NOTEEVENT_H
+
+#include <cstdint>
+
+namespace audio::Sequencing {
+    enum class EventType : uint8_t {
+        NoteOff, // Sorts before NoteOn at the same sample, so back to back notes retrigger cleanly
+        NoteOn
+    };
+
+    // A note event stamped with the output sample it has to be applied at.
+    struct NoteEvent {
+        uint64_t time;
+        uint32_t epoch; // Stamped by the generator queue, events from before a flush are dropped
+        EventType type;
+        uint8_t note;
+        uint8_t velocity;
+    };
+}
+
+#endif //NOTEEVENT_H
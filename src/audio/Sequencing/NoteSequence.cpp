@@ -2,5 +2,16 @@
 
 namespace audio {
 namespace Sequencing {
+    void NoteSequence::add_note(const Note &note) {
+        notes.insert(note);
+    }
+
+    bool NoteSequence::remove_note(const Note &note) {
+        return notes.erase(note);
+    }
+
+    bool NoteSequence::shares_notes_with(const NoteSequence &other) const {
+        return generator == other.generator && notes.shares_storage_with(other.notes);
+    }
 } // Sequencing
-} // audio
\ No newline at end of file
+} // audio
@@ -1,9 +1,8 @@
 #ifndef NOTESEQUENCE_H
 #define NOTESEQUENCE_H
 
-#include <vector>
-
 #include "Note.h"
+#include "NoteStorage.h"
 #include "audio/AudioGenerator.h"
 
 namespace audio {
@@ -11,22 +10,17 @@ namespace Sequencing {
 
 class NoteSequence {
 public:
-    std::vector<Note> notes; // List of notes in this sequence
+    NoteStorage notes; // List of notes in this sequence, sorted by tick and shared with copies of it
     AudioGenerator *generator = nullptr; // Pointer to the generator this sequence is associated with
 
-    void update(uint64_t current_sample) {
-        // Update the sequence based on the current sample
-        for (auto& note : notes) {
-            if (!note.is_playing && note.play_time <= current_sample && note.stop_time > current_sample) {
-                // Note is currently active, process it
-                generator->NoteOn(note);
-                note.is_playing = true; // Mark the note as playing
-            } else if (note.stop_time <= current_sample) {
-                // Note has ended, send NoteOff
-                generator->NoteOff(note);
-            }
-        }
-    }
+    // Inserts a note at its sorted position.
+    void add_note(const Note& note);
+
+    // Removes a note added earlier (same tick, length and pitch), false when it is not there.
+    bool remove_note(const Note& note);
+
+    // True when both play the same generator and neither changed its notes since one was copied.
+    [[nodiscard]] bool shares_notes_with(const NoteSequence& other) const;
 };
 
 } // Sequencing
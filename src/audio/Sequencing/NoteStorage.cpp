@@ -0,0 +1,95 @@
+#include "NoteStorage.h"
+
+#include <algorithm>
+
+namespace audio {
+namespace Sequencing {
+    namespace {
+        bool tick_before(uint32_t tick, const Note& note) {
+            return tick < note.tick;
+        }
+
+        bool before_tick(const Note& note, uint32_t tick) {
+            return note.tick < tick;
+        }
+    }
+
+    NoteStorage::Chunk& NoteStorage::writable(size_t chunk) {
+        // Only copies taken under the patterns lock can share a chunk, and this runs under that lock too
+        if (chunks[chunk].use_count() > 1) {
+            auto copy = std::make_shared<Chunk>();
+            copy->reserve(chunk_capacity);
+            copy->assign(chunks[chunk]->begin(), chunks[chunk]->end());
+            chunks[chunk] = std::move(copy);
+        }
+        return *chunks[chunk];
+    }
+
+    void NoteStorage::drop_empty_chunks() {
+        std::erase_if(chunks, [](const ChunkPtr& chunk) { return chunk->empty(); });
+    }
+
+    void NoteStorage::insert(const Note& note) {
+        // First chunk with a later note, or the last one when the note goes at the very end
+        auto it = std::upper_bound(chunks.begin(), chunks.end(), note.tick, [](uint32_t tick, const ChunkPtr& chunk) {
+            return tick < chunk->back().tick;
+        });
+        if (it == chunks.end() && !chunks.empty()) {
+            --it;
+        }
+
+        // Appending to a full last chunk (recording, imports) starts a new one instead of splitting
+        if (it == chunks.end() || (it + 1 == chunks.end() && (*it)->size() >= chunk_capacity && (*it)->back().tick <= note.tick)) {
+            auto chunk = std::make_shared<Chunk>();
+            chunk->reserve(chunk_capacity);
+            chunk->push_back(note);
+            chunks.push_back(std::move(chunk));
+            ++count;
+            return;
+        }
+
+        const auto index = static_cast<size_t>(it - chunks.begin());
+        Chunk& chunk = writable(index);
+        chunk.insert(std::upper_bound(chunk.begin(), chunk.end(), note.tick, tick_before), note);
+        ++count;
+
+        if (chunk.size() > chunk_capacity) {
+            auto upper = std::make_shared<Chunk>();
+            upper->reserve(chunk_capacity);
+            upper->assign(chunk.begin() + static_cast<std::ptrdiff_t>(chunk.size() / 2), chunk.end());
+            chunk.resize(chunk.size() / 2);
+            chunks.insert(chunks.begin() + static_cast<std::ptrdiff_t>(index + 1), std::move(upper));
+        }
+    }
+
+    bool NoteStorage::erase(const Note& note) {
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), note.tick, [](const ChunkPtr& chunk, uint32_t tick) {
+            return chunk->back().tick < tick;
+        });
+
+        // Notes on the same tick can spill over into the next chunks
+        for (; it != chunks.end() && (*it)->front().tick <= note.tick; ++it) {
+            const Chunk& chunk = **it;
+            auto first = std::lower_bound(chunk.begin(), chunk.end(), note.tick, before_tick);
+            for (auto n = first; n != chunk.end() && n->tick == note.tick; ++n) {
+                if (n->length == note.length && n->pitch == note.pitch) {
+                    const auto position = n - chunk.begin();
+                    Chunk& target = writable(static_cast<size_t>(it - chunks.begin()));
+                    target.erase(target.begin() + position);
+                    --count;
+                    if (target.empty()) {
+                        chunks.erase(it);
+                    }
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void NoteStorage::clear() {
+        chunks.clear();
+        count = 0;
+    }
+} // Sequencing
+} // audio
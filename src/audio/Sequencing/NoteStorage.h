@@ -0,0 +1,102 @@
+#ifndef NOTESTORAGE_H
+#define NOTESTORAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "Note.h"
+
+namespace audio {
+namespace Sequencing {
+
+// Notes sorted by tick, stored in fixed size chunks that copies share. Copying only copies the chunk
+// pointers, an edit clones the single chunk it touches when something else still holds it, so pattern
+// clones and undo snapshots cost the chunks that changed.
+// Edit only while holding SequencerState::lock_patterns(): copies for compiling and undo are taken under
+// it and read the shared chunks from other threads.
+class NoteStorage {
+    using Chunk = std::vector<Note>;
+    using ChunkPtr = std::shared_ptr<Chunk>;
+
+public:
+    static constexpr size_t chunk_capacity = 256;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Note;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Note*;
+        using reference = const Note&;
+
+        const_iterator() = default;
+        const_iterator(const std::vector<ChunkPtr>* chunks, size_t chunk, size_t offset) : chunks(chunks), chunk(chunk), offset(offset) {}
+
+        reference operator*() const { return (*(*chunks)[chunk])[offset]; }
+        pointer operator->() const { return &**this; }
+
+        const_iterator& operator++() {
+            if (++offset == (*chunks)[chunk]->size()) {
+                ++chunk;
+                offset = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const const_iterator& other) const { return chunk == other.chunk && offset == other.offset; }
+
+    private:
+        const std::vector<ChunkPtr>* chunks = nullptr;
+        size_t chunk = 0;
+        size_t offset = 0;
+    };
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] const_iterator begin() const { return {&chunks, 0, 0}; }
+    [[nodiscard]] const_iterator end() const { return {&chunks, chunks.size(), 0}; }
+
+    // Inserts after the notes that start on the same tick.
+    void insert(const Note& note);
+    // Removes the first note with the same tick, length and pitch, false when there is none.
+    bool erase(const Note& note);
+    void clear();
+
+    template <class Predicate>
+    size_t erase_if(Predicate predicate) {
+        size_t removed = 0;
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            const Chunk& chunk = *chunks[c];
+            if (std::find_if(chunk.begin(), chunk.end(), predicate) != chunk.end()) {
+                removed += std::erase_if(writable(c), predicate);
+            }
+        }
+        count -= removed;
+        drop_empty_chunks();
+        return removed;
+    }
+
+    // True when both hold exactly the same chunks, i.e. neither was edited since one was copied from the other.
+    [[nodiscard]] bool shares_storage_with(const NoteStorage& other) const { return chunks == other.chunks; }
+
+private:
+    std::vector<ChunkPtr> chunks; // Never empty chunks, each sorted and in order
+    size_t count = 0;
+
+    Chunk& writable(size_t chunk);
+    void drop_empty_chunks();
+};
+
+} // Sequencing
+} // audio
+
+#endif //NOTESTORAGE_H
@@ -1,6 +1,9 @@
 #ifndef PATTERN_H
 #define PATTERN_H
+#include "Groove.h"
 #include "NoteSequence.h"
+#include "StepSequence.h"
+#include <string>
 #include <vector>
 
 namespace audio {
@@ -12,34 +15,21 @@ public:
     std::string name = "Pattern";
     int id; // Unique identifier for the pattern
     std::vector<NoteSequence> note_sequences;
-    void update(uint64_t current_sample) {
-        // Update all note sequences in this pattern
-        for (auto& sequence : note_sequences) {
-            sequence.update(current_sample);
-        }
-    }
+    std::vector<StepSequence> step_sequences; // Drum grids, played alongside the note sequences
+    Groove groove; // Baked into the compiled timeline, the notes themselves stay on the grid
 
-    void stop() {
-        // Stop all note sequences in this pattern
-        for (auto& sequence : note_sequences) {
-            for (auto& note : sequence.notes) {
-                if (note.is_playing) {
-                    sequence.generator->NoteOff(note);
-                    note.is_playing = false; // Mark the note as not playing
-                }
-            }
+    // True when nothing in the pattern changed since one was copied from the other, so its compiled
+    // timeline can be kept. Cheap, it compares shared note chunks rather than notes.
+    [[nodiscard]] bool shares_notes_with(const Pattern& other) const {
+        if (id != other.id || groove != other.groove || step_sequences != other.step_sequences || note_sequences.size() != other.note_sequences.size()) {
+            return false;
         }
-    }
-
-    void pause() {
-        // Pause all note sequences in this pattern
-        for (auto& sequence : note_sequences) {
-            for (auto& note : sequence.notes) {
-                if (note.is_playing) {
-                    sequence.generator->NoteOff(note);
-                }
+        for (size_t i = 0; i < note_sequences.size(); ++i) {
+            if (!note_sequences[i].shares_notes_with(other.note_sequences[i])) {
+                return false;
             }
         }
+        return true;
     }
 };
 
@@ -0,0 +1,147 @@
+#include "Recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "SequencerState.h"
+
+namespace audio {
+namespace Sequencing {
+    Recorder::Recorder(SequencerState& state) : state(state) {
+        thread = std::jthread([this](std::stop_token stop) { run(stop); });
+    }
+
+    Recorder::~Recorder() {
+        thread.request_stop();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    void Recorder::arm(int pattern_id) {
+        armed_pattern.store(pattern_id, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+
+    void Recorder::disarm() {
+        armed_pattern.store(-1, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+
+    void Recorder::capture(AudioGenerator* generator, const NoteEvent& event) {
+        if (armed_pattern.load(std::memory_order_relaxed) == -1 || !state.is_playing_state()) {
+            return;
+        }
+        if (!ring.push({generator, event, state.get_song_at(event.time)})) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Recorder::run(std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            {
+                std::unique_lock lock(wake_mutex);
+                wake.wait_for(lock, stop, std::chrono::milliseconds(50), [this] {
+                    return armed_pattern.load(std::memory_order_relaxed) != take_pattern;
+                });
+            }
+
+            const int armed = armed_pattern.load(std::memory_order_relaxed);
+            if (armed != take_pattern) {
+                // What was captured before the switch still belongs to the take that was armed then
+                if (take_pattern != -1) {
+                    drain();
+                    end_take();
+                }
+                take_pattern = armed;
+            }
+            drain();
+            merge();
+        }
+    }
+
+    void Recorder::drain() {
+        Captured captured{};
+        while (ring.pop(captured)) {
+            const NoteEvent& event = captured.event;
+            // Retriggering a held note ends it first
+            const auto it = std::find_if(held.begin(), held.end(), [&](const Held& h) {
+                return h.generator == captured.generator && h.note == event.note;
+            });
+            if (it != held.end()) {
+                finish(*it, event.time);
+                held.erase(it);
+            }
+            if (event.type == EventType::NoteOn && take_pattern != -1) {
+                held.push_back({captured.generator, event.note, event.velocity, event.time, state.get_tick_at_song(captured.song)});
+            }
+        }
+    }
+
+    void Recorder::finish(const Held& note, uint64_t stop) {
+        // Measured in samples rather than as the difference of two ticks, a note held across a loop wrap keeps its length
+        const double samples = static_cast<double>(stop > note.start ? stop - note.start : 0);
+        const double ticks = samples * TempoMap::ticks_per_quarter / state.get_samples_per_quarter();
+        const auto length = static_cast<uint32_t>(std::clamp(std::llround(ticks), 1ll, static_cast<long long>(UINT32_MAX)));
+
+        Note recorded;
+        recorded.length = length;
+        recorded.pitch = note.note;
+        recorded.velocity = note.velocity;
+        finished.push_back({note.generator, note.tick, recorded});
+    }
+
+    void Recorder::end_take() {
+        const uint64_t now = state.get_current_process_sample();
+        for (const auto& note : held) {
+            finish(note, now);
+        }
+        held.clear();
+        merge();
+        take_recorded = false;
+    }
+
+    void Recorder::merge() {
+        if (finished.empty() || take_pattern == -1) {
+            finished.clear();
+            return;
+        }
+        if (!take_recorded) {
+            state.record_undo();
+            take_recorded = true;
+        }
+
+        {
+            auto lock = state.lock_patterns();
+            auto pattern = std::find_if(state.patterns.begin(), state.patterns.end(), [this](const Pattern& p) {
+                return p.id == take_pattern;
+            });
+            if (pattern != state.patterns.end()) {
+                for (auto& recorded : finished) {
+                    // Into the instance of the pattern that was playing, or the pattern's own ticks when none was
+                    uint64_t tick = recorded.tick;
+                    for (const auto& instance : state.arrangement.instances) {
+                        if (instance.pattern_id == take_pattern && tick >= instance.start && tick < instance.end()) {
+                            tick = instance.to_pattern(tick);
+                            break;
+                        }
+                    }
+                    recorded.note.tick = static_cast<uint32_t>(std::min<uint64_t>(tick, UINT32_MAX));
+
+                    auto sequence = std::find_if(pattern->note_sequences.begin(), pattern->note_sequences.end(), [&](const NoteSequence& s) {
+                        return s.generator == recorded.generator;
+                    });
+                    if (sequence == pattern->note_sequences.end()) {
+                        sequence = pattern->note_sequences.emplace(pattern->note_sequences.end());
+                        sequence->generator = recorded.generator;
+                    }
+                    sequence->add_note(recorded.note);
+                }
+            }
+        }
+        state.mark_dirty(take_pattern);
+        finished.clear();
+    }
+} // Sequencing
+} // audio
@@ -0,0 +1,93 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Note.h"
+#include "NoteEvent.h"
+#include "audio/AudioGenerator.h"
+#include "audio/MpscQueue.h"
+
+namespace audio {
+namespace Sequencing {
+
+class SequencerState;
+
+// Records live input into a pattern while the transport plays. The MIDI threads only push timestamped events
+// into a lock free ring, a background thread pairs NoteOns with their NoteOffs and merges the finished notes
+// in batches through lock_patterns() and mark_dirty(), like an edit from the UI. One take is one undo step.
+class Recorder {
+public:
+    static constexpr size_t capacity = 8192; // Events between two merges, a few seconds of dense playing
+
+    explicit Recorder(SequencerState& state);
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // Starts a take into the pattern, each note lands in the sequence of the generator that played it.
+    void arm(int pattern_id);
+    // Ends the take, notes still held end now.
+    void disarm();
+
+    [[nodiscard]] int get_pattern() const { return armed_pattern.load(std::memory_order_relaxed); } // -1 when not armed
+    [[nodiscard]] uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    // MIDI input threads, lock free. Ignored unless armed and playing, dropped (and counted) when the ring is full.
+    void capture(AudioGenerator* generator, const NoteEvent& event);
+
+private:
+    struct Captured {
+        AudioGenerator* generator;
+        NoteEvent event; // Time in output samples
+        uint64_t song; // Song samples, resolved on capture while the lap it was played in is still known
+    };
+
+    // A NoteOn still waiting for its NoteOff
+    struct Held {
+        AudioGenerator* generator;
+        uint8_t note;
+        uint8_t velocity;
+        uint64_t start; // Output samples
+        uint64_t tick; // Song ticks
+    };
+
+    struct Recorded {
+        AudioGenerator* generator;
+        uint64_t tick; // Song ticks, placed in the pattern when merged
+        Note note;
+    };
+
+    SequencerState& state;
+    std::atomic<int> armed_pattern = -1;
+    std::atomic<uint64_t> dropped = 0;
+    MpscQueue<Captured, capacity> ring;
+
+    std::mutex wake_mutex;
+    std::condition_variable_any wake;
+
+    // Recording thread
+    int take_pattern = -1;
+    bool take_recorded = false; // Its undo step has been taken
+    std::vector<Held> held;
+    std::vector<Recorded> finished;
+
+    std::jthread thread;
+
+    void run(std::stop_token stop);
+    void drain();
+    void finish(const Held& note, uint64_t stop);
+    void end_take();
+    void merge();
+};
+
+} // Sequencing
+} // audio
+
+#endif //RECORDER_H
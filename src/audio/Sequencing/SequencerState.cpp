@@ -1,6 +1,669 @@
 #include "SequencerState.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace audio {
 namespace Sequencing {
+    namespace {
+        // A clip loops over its pattern rounded up to whole bars, at least one
+        uint64_t clip_length(const EventTimeline* events) {
+            if (events == nullptr) {
+                return 0;
+            }
+            constexpr uint64_t bar = 4 * TempoMap::ticks_per_quarter;
+            return std::max<uint64_t>((events->end_tick() + bar - 1) / bar, 1) * bar;
+        }
+    }
+
+    SequencerState::SequencerState() : song(new CompiledSong()) {
+        sequencer_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+    }
+
+    SequencerState::~SequencerState() {
+        sequencer_thread.request_stop();
+        if (sequencer_thread.joinable()) {
+            sequencer_thread.join();
+        }
+        delete song;
+    }
+
+    uint64_t SequencerState::get_current_sample() {
+        std::lock_guard lock(transport_mutex);
+        return song_at(get_current_process_sample());
+    }
+
+    uint64_t SequencerState::get_current_tick() {
+        std::lock_guard lock(transport_mutex);
+        return tempo.tick_at(song_at(get_current_process_sample()));
+    }
+
+    uint64_t SequencerState::get_song_at(uint64_t output) const {
+        uint32_t before;
+        uint64_t song;
+        do {
+            before = laps_sequence.load(std::memory_order_acquire);
+            const uint32_t count = std::min<uint32_t>(laps_count.load(std::memory_order_relaxed), published_laps);
+            song = count == 0 ? laps_stopped_song.load(std::memory_order_relaxed) : laps_song[0].load(std::memory_order_relaxed);
+            // Same walk as song_at, the latest lap the output has reached
+            for (uint32_t i = count; i-- > 0;) {
+                const uint64_t start = laps_output[i].load(std::memory_order_relaxed);
+                if (output >= start) {
+                    song = laps_song[i].load(std::memory_order_relaxed) + (output - start);
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((before & 1) != 0 || before != laps_sequence.load(std::memory_order_relaxed));
+        return song;
+    }
+
+    uint64_t SequencerState::get_tick_at_song(uint64_t song) {
+        std::lock_guard lock(transport_mutex);
+        return tempo.tick_at(song);
+    }
+
+    void SequencerState::start() {
+        is_playing = true;
+        std::lock_guard lock(transport_mutex);
+        commands.push_back({Command::Start});
+        transport_changed.notify_one();
+    }
+
+    void SequencerState::pause() {
+        is_playing = false;
+        std::lock_guard lock(transport_mutex);
+        commands.push_back({Command::Pause});
+        transport_changed.notify_one();
+    }
+
+    void SequencerState::reset() {
+        is_playing = false;
+        for (auto& callback : reset_callbacks) {
+            callback();
+        }
+
+        std::lock_guard lock(transport_mutex);
+        commands.push_back({Command::Reset});
+        transport_changed.notify_one();
+    }
+
+    void SequencerState::seek(uint64_t sample) {
+        std::lock_guard lock(transport_mutex);
+        commands.push_back({Command::Seek, sample});
+        transport_changed.notify_one();
+    }
+
+    void SequencerState::set_loop(const LoopRegion& region) {
+        std::lock_guard lock(transport_mutex);
+        loop = region;
+        cache_loop_start();
+    }
+
+    SequencerState::LoopRegion SequencerState::get_loop() {
+        std::lock_guard lock(transport_mutex);
+        return loop;
+    }
+
+    void SequencerState::set_tempo_map(const TempoMap& map) {
+        std::lock_guard lock(transport_mutex);
+        if (playing) {
+            // Events up to the frontier are queued with the old tempo, carry on from the same tick with the new one
+            const uint64_t frontier_output = output_at(scheduled_song);
+            const uint64_t tick = tempo.tick_at(scheduled_song);
+            tempo = map;
+            scheduled_song = tempo.sample_at(tick);
+            anchors.push_back({scheduled_song, frontier_output});
+        } else {
+            const uint64_t tick = tempo.tick_at(anchor_song);
+            tempo = map;
+            anchor_song = tempo.sample_at(tick);
+        }
+        cache_loop_start();
+    }
+
+    TempoMap SequencerState::get_tempo_map() {
+        std::lock_guard lock(transport_mutex);
+        return tempo;
+    }
+
+    void SequencerState::set_lookahead(uint64_t samples) {
+        std::lock_guard lock(transport_mutex);
+        lookahead = samples;
+    }
+
+    bool SequencerState::launch_clip(AudioGenerator* generator, int pattern_id, Quantize quantize) {
+        if (!clip_commands.push({generator, pattern_id, quantize})) {
+            return false;
+        }
+        // Without the lock a wakeup can be missed, the 2 ms wait bounds what that costs
+        transport_changed.notify_one();
+        return true;
+    }
+
+    bool SequencerState::stop_clip(AudioGenerator* generator, Quantize quantize) {
+        return launch_clip(generator, -1, quantize);
+    }
+
+    std::vector<SequencerState::ClipSlot> SequencerState::get_clips() {
+        std::lock_guard lock(transport_mutex);
+        const uint64_t tick = tempo.tick_at(song_at(get_current_process_sample()));
+        std::vector<ClipSlot> slots;
+        for (const auto& clip : clips) {
+            if (clip.stop > tick) {
+                slots.push_back({clip.generator, clip.pattern_id, playing && clip.start <= tick});
+            }
+        }
+        return slots;
+    }
+
+    void SequencerState::record_undo() {
+        auto lock = lock_patterns();
+        history.record({patterns, arrangement});
+    }
+
+    bool SequencerState::undo() {
+        auto lock = lock_patterns();
+        EditHistory::Snapshot current{patterns, arrangement};
+        if (!history.undo(current)) {
+            return false;
+        }
+        restore(current);
+        return true;
+    }
+
+    bool SequencerState::redo() {
+        auto lock = lock_patterns();
+        EditHistory::Snapshot current{patterns, arrangement};
+        if (!history.redo(current)) {
+            return false;
+        }
+        restore(current);
+        return true;
+    }
+
+    bool SequencerState::can_undo() {
+        auto lock = lock_patterns();
+        return history.can_undo();
+    }
+
+    bool SequencerState::can_redo() {
+        auto lock = lock_patterns();
+        return history.can_redo();
+    }
+
+    void SequencerState::restore(EditHistory::Snapshot& snapshot) {
+        // Only patterns whose chunks differ are recompiled, an undo on one pattern of a large song stays cheap
+        for (const auto& pattern : patterns) {
+            auto it = std::find_if(snapshot.patterns.begin(), snapshot.patterns.end(), [&](const Pattern& p) { return p.id == pattern.id; });
+            if (it == snapshot.patterns.end() || !it->shares_notes_with(pattern)) {
+                mark_dirty(pattern.id);
+            }
+        }
+        for (const auto& pattern : snapshot.patterns) {
+            auto it = std::find_if(patterns.begin(), patterns.end(), [&](const Pattern& p) { return p.id == pattern.id; });
+            if (it == patterns.end()) {
+                mark_dirty(pattern.id);
+            }
+        }
+        patterns = std::move(snapshot.patterns);
+        arrangement = std::move(snapshot.arrangement);
+        mark_arrangement_dirty();
+    }
+
+    uint64_t SequencerState::song_at(uint64_t output) const {
+        if (!playing || anchors.empty()) {
+            return anchor_song;
+        }
+        // Laps that are already queued but not yet heard must not show up early
+        for (auto it = anchors.rbegin(); it != anchors.rend(); ++it) {
+            if (output >= it->output) {
+                return it->song + (output - it->output);
+            }
+        }
+        return anchors.front().song;
+    }
+
+    uint64_t SequencerState::output_at(uint64_t song) const {
+        return anchors.back().output + (song - anchors.back().song);
+    }
+
+    bool SequencerState::send(AudioGenerator* generator, const NoteEvent& event) {
+        if (std::find(touched.begin(), touched.end(), generator) == touched.end()) {
+            touched.push_back(generator);
+        }
+        return generator->Schedule(event);
+    }
+
+    void SequencerState::cache_loop_start() {
+        if (loop.active()) {
+            enter(tempo.tick_at(loop.start), loop_active, loop_chased);
+        } else {
+            loop_active.clear();
+            loop_chased.clear();
+        }
+    }
+
+    void SequencerState::enter(uint64_t tick, std::vector<ActiveInstance>& instances, std::vector<HeldNote>& held) {
+        instances.clear();
+        held.clear();
+
+        found.clear();
+        song->arrangement.overlapping(tick, tick + 1, found);
+        std::vector<uint32_t> events_held;
+        for (uint32_t index : found) {
+            const auto& entry = song->arrangement[index];
+            const uint64_t local = entry.instance.to_pattern(tick);
+            instances.push_back({index, entry.instance, entry.events, nullptr, entry.events->lower_bound(local)});
+
+            // Notes that started before the instance's offset never play, so they are not chased either
+            entry.events->sounding_at(local, events_held);
+            for (uint32_t event : events_held) {
+                if (entry.events->ticks[event] >= entry.instance.offset) {
+                    held.push_back({index, event});
+                }
+            }
+        }
+    }
+
+    void SequencerState::activate(uint64_t from_tick, uint64_t to_tick) {
+        // Only instances overlapping this pass are looked at, the ones already being walked keep their cursor
+        found.clear();
+        song->arrangement.overlapping(from_tick, to_tick, found);
+        for (uint32_t index : found) {
+            auto it = std::find_if(active.begin(), active.end(), [index](const ActiveInstance& a) { return a.index == index; });
+            if (it == active.end()) {
+                const auto& entry = song->arrangement[index];
+                const size_t cursor = entry.events->lower_bound(entry.instance.to_pattern(std::max(from_tick, entry.instance.start)));
+                active.push_back({index, entry.instance, entry.events, nullptr, cursor});
+            }
+        }
+        activate_clips(from_tick, to_tick);
+    }
+
+    void SequencerState::activate_clips(uint64_t from_tick, uint64_t to_tick) {
+        // Clips that stopped before this pass and are not walked any more are gone
+        std::erase_if(clips, [&](const Clip& clip) {
+            return clip.stop <= from_tick && std::none_of(active.begin(), active.end(), [&](const ActiveInstance& a) { return a.index == clip.tag; });
+        });
+
+        for (const auto& clip : clips) {
+            if (clip.events == nullptr || clip.length == 0 || std::any_of(active.begin(), active.end(), [&](const ActiveInstance& a) { return a.index == clip.tag; })) {
+                continue;
+            }
+            // The lap the pass starts in, a clip plays from its launch point on
+            const uint64_t from = std::max(from_tick, clip.start);
+            if (from >= to_tick || from >= clip.stop) {
+                continue;
+            }
+            const uint64_t lap = clip.start + (from - clip.start) / clip.length * clip.length;
+            const PatternInstance instance{clip.pattern_id, lap, std::min(clip.length, clip.stop - lap), 0};
+            active.push_back({clip.tag, instance, clip.events, clip.generator, clip.events->lower_bound(from - lap)});
+        }
+    }
+
+    bool SequencerState::next_lap(ActiveInstance& lap) {
+        auto clip = std::find_if(clips.begin(), clips.end(), [&](const Clip& c) { return c.tag == lap.index; });
+        if (clip == clips.end() || clip->events == nullptr || lap.instance.end() >= clip->stop) {
+            if (clip != clips.end()) {
+                clips.erase(clip);
+            }
+            return false;
+        }
+        lap.instance.start = lap.instance.end();
+        lap.instance.length = std::min(clip->length, clip->stop - lap.instance.start);
+        lap.events = clip->events;
+        lap.cursor = 0;
+        return true;
+    }
+
+    void SequencerState::apply_clip(const ClipCommand& command) {
+        // The first quantize point the sequencer has not scheduled past, so the switch still lands exactly on it
+        const uint64_t grid = command.quantize == Quantize::Beat ? TempoMap::ticks_per_quarter : 4 * TempoMap::ticks_per_quarter;
+        const uint64_t frontier = tempo.tick_at(playing ? scheduled_song : anchor_song);
+        const uint64_t at = (frontier + grid - 1) / grid * grid;
+
+        // Whatever plays on the generator ends there, a launch still waiting is replaced outright
+        std::erase_if(clips, [&](const Clip& clip) {
+            return clip.generator == command.generator && clip.start >= at && std::none_of(active.begin(), active.end(), [&](const ActiveInstance& a) { return a.index == clip.tag; });
+        });
+        for (auto& clip : clips) {
+            if (clip.generator == command.generator && clip.stop > at) {
+                clip.stop = std::max(at, clip.start);
+                for (auto& a : active) {
+                    if (a.index == clip.tag) {
+                        a.instance.length = std::min(a.instance.length, clip.stop - std::min(clip.stop, a.instance.start));
+                    }
+                }
+            }
+        }
+
+        if (command.pattern_id < 0) {
+            return;
+        }
+        const EventTimeline* events = song->find(command.pattern_id);
+        clips.push_back({command.generator, command.pattern_id, events, at, clip_length(events), UINT64_MAX, next_clip_tag++});
+        if (next_clip_tag == no_instance) {
+            next_clip_tag = first_clip_tag;
+        }
+    }
+
+    void SequencerState::run(std::stop_token stop) {
+        std::unique_lock lock(transport_mutex);
+        while (!stop.stop_requested()) {
+            // A few wakeups per block at typical buffer sizes, well inside the default lookahead
+            transport_changed.wait_for(lock, stop, std::chrono::milliseconds(2), [this] { return !commands.empty() || !clip_commands.empty(); });
+
+            CompiledSong* next = compiler.adopt(song);
+            if (next != song) {
+                // Arrangement indices change with the song, the next pass picks the instances up again
+                song = next;
+                active.clear();
+                for (auto& s : sounding) {
+                    s.instance = no_instance;
+                }
+                for (auto& clip : clips) {
+                    clip.events = song->find(clip.pattern_id);
+                    if (clip.length == 0) {
+                        clip.length = clip_length(clip.events);
+                    }
+                }
+                cache_loop_start();
+            }
+
+            const uint64_t now = get_current_process_sample();
+            for (const auto& pending : commands) {
+                apply(pending, now);
+            }
+            commands.clear();
+
+            ClipCommand clip;
+            while (clip_commands.pop(clip)) {
+                apply_clip(clip);
+            }
+
+            const uint64_t tick = tempo.tick_at(song_at(now));
+            samples_per_quarter.store(tempo.get_sample_rate() * 60.0 / tempo.bpm_at(tick), std::memory_order_relaxed);
+
+            schedule(now);
+            publish_laps();
+        }
+    }
+
+    void SequencerState::publish_laps() {
+        // Odd while writing, readers retry until they see the same even value on both sides
+        laps_sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        uint32_t count = 0;
+        if (playing && !anchors.empty()) {
+            const auto store = [&](const Anchor& anchor) {
+                laps_song[count].store(anchor.song, std::memory_order_relaxed);
+                laps_output[count].store(anchor.output, std::memory_order_relaxed);
+                ++count;
+            };
+            if (has_retired) {
+                store(retired);
+            }
+            for (size_t i = 0; i < anchors.size() && count < published_laps; ++i) {
+                store(anchors[i]);
+            }
+        }
+        laps_count.store(count, std::memory_order_relaxed);
+        laps_stopped_song.store(anchor_song, std::memory_order_relaxed);
+        laps_sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    void SequencerState::chase(const std::vector<HeldNote>& held, uint64_t output) {
+        // The notes sound from output until their normal NoteOff, or the end of their instance
+        for (const auto& h : held) {
+            const auto& entry = song->arrangement[h.instance];
+            const auto& events = *entry.events;
+            AudioGenerator* generator = events.generator_table[events.generators[h.event]];
+            if (!roll(events.chances[h.event])) {
+                continue;
+            }
+            if (!send(generator, {output, 0, EventType::NoteOn, events.notes[h.event], events.velocities[h.event]})) {
+                break; // Queue full, the rest stays silent until its next NoteOn
+            }
+            const uint64_t stop = std::min(entry.instance.to_song(events.stop_ticks[h.event]), entry.instance.end());
+            sounding.push_back({generator, events.notes[h.event], output, output_at(tempo.sample_at(stop)), false, h.instance});
+        }
+    }
+
+    bool SequencerState::roll(uint8_t chance) {
+        if (chance >= 100) {
+            return true;
+        }
+        // xorshift32, cheap enough to roll for every hit of a dense grid
+        chance_state ^= chance_state << 13;
+        chance_state ^= chance_state >> 17;
+        chance_state ^= chance_state << 5;
+        return chance_state % 100 < chance;
+    }
+
+    void SequencerState::begin_output(uint64_t now) {
+        anchors.assign(1, {anchor_song, now});
+        has_retired = false;
+        scheduled_song = anchor_song;
+        enter(tempo.tick_at(anchor_song), active, chased);
+        chase(chased, now);
+    }
+
+    void SequencerState::stop_output(uint64_t now) {
+        // Whatever is still queued belongs to the old playback, drop it and end what is actually sounding.
+        // Events before now have been rendered already, everything from now on gets flushed.
+        for (auto* generator : touched) {
+            generator->FlushScheduled();
+        }
+        for (const auto& s : sounding) {
+            if (s.start_output < now && s.stop_output >= now) {
+                s.generator->Schedule({now, 0, EventType::NoteOff, s.note, 0});
+            }
+        }
+        sounding.clear();
+        anchors.clear();
+        has_retired = false;
+        active.clear();
+    }
+
+    void SequencerState::wrap(uint64_t output) {
+        // Notes still held at the loop end are cut there, their NoteOffs lie past it and are never reached
+        for (auto& s : sounding) {
+            if (!s.off_scheduled && s.stop_output >= output && send(s.generator, {output, 0, EventType::NoteOff, s.note, 0})) {
+                s.off_scheduled = true;
+                s.stop_output = output;
+            }
+        }
+
+        anchors.push_back({loop.start, output});
+        active = loop_active;
+        scheduled_song = loop.start;
+        chase(loop_chased, output);
+    }
+
+    void SequencerState::apply(const PendingCommand& pending, uint64_t now) {
+        switch (pending.command) {
+            case Command::Start:
+                if (playing) {
+                    return;
+                }
+                playing = true;
+                begin_output(now);
+                break;
+            case Command::Pause:
+                if (!playing) {
+                    return;
+                }
+                anchor_song = song_at(now);
+                stop_output(now);
+                playing = false;
+                break;
+            case Command::Reset:
+                stop_output(now);
+                playing = false;
+                anchor_song = 0;
+                clips.clear();
+                break;
+            case Command::Seek:
+                stop_output(now);
+                anchor_song = pending.sample;
+                if (playing) {
+                    begin_output(now);
+                }
+                break;
+        }
+    }
+
+    bool SequencerState::cut(uint32_t instance, uint64_t output) {
+        for (auto& s : sounding) {
+            if (s.instance == instance && !s.off_scheduled && s.stop_output >= output) {
+                if (!send(s.generator, {output, 0, EventType::NoteOff, s.note, 0})) {
+                    return false;
+                }
+                s.off_scheduled = true;
+                s.stop_output = output;
+            }
+        }
+        return true;
+    }
+
+    SequencerState::DueInstance SequencerState::due_at(uint32_t slot) const {
+        // An instance ending counts as a NoteOff
+        const auto& a = active[slot];
+        const auto& events = *a.events;
+        const bool ends = a.cursor >= events.size() || events.ticks[a.cursor] >= a.instance.offset + a.instance.length;
+        const uint64_t tick = ends ? a.instance.end() : a.instance.to_song(events.ticks[a.cursor]);
+        return {tick, ends ? EventType::NoteOff : events.types[a.cursor], slot, ends};
+    }
+
+    bool SequencerState::queue_until(uint64_t song_end) {
+        const uint64_t from_tick = tempo.tick_at(scheduled_song);
+        const uint64_t to_tick = tempo.tick_at(song_end); // Events before it fall before song_end
+        activate(from_tick, to_tick);
+
+        // The next event across the active instances comes off a heap of their cursors, O(log k) per event.
+        // Instances that end are only dropped from active once the pass is over, so the slots stay put.
+        const auto later = std::greater<DueInstance>();
+        due.clear();
+        for (uint32_t slot = 0; slot < active.size(); ++slot) {
+            due.push_back(due_at(slot));
+        }
+        std::make_heap(due.begin(), due.end(), later);
+        const auto finish = [this] {
+            std::erase_if(active, [](const ActiveInstance& a) { return a.events == nullptr; });
+        };
+        const auto requeue = [&](uint32_t slot) {
+            due.back() = due_at(slot);
+            std::push_heap(due.begin(), due.end(), later);
+        };
+
+        // One binary search into the tempo map per pass, the merged events come in tick order from here on
+        TempoMap::Cursor convert(tempo, from_tick);
+        for (;;) {
+            if (due.empty() || due.front().tick >= to_tick) {
+                scheduled_song = song_end;
+                finish();
+                return true;
+            }
+            std::pop_heap(due.begin(), due.end(), later);
+            const DueInstance next = due.back();
+
+            const uint64_t position = convert.sample_at(next.tick);
+            const uint64_t output = output_at(position);
+            auto& current = active[next.slot];
+
+            if (next.ends) {
+                // Notes still held at the end of the instance are cut there, a clip goes on with its next lap
+                if (!cut(current.index, output)) {
+                    scheduled_song = position;
+                    finish();
+                    return false;
+                }
+                if (current.index < first_clip_tag || !next_lap(current)) {
+                    current.events = nullptr; // Walked to its end
+                    due.pop_back();
+                } else {
+                    requeue(next.slot);
+                }
+                continue;
+            }
+
+            const auto& events = *current.events;
+            const size_t i = current.cursor;
+            AudioGenerator* generator = events.generator_table[events.generators[i]];
+            if (current.only != nullptr && generator != current.only) {
+                ++current.cursor;
+                requeue(next.slot);
+                continue;
+            }
+            const NoteEvent event{output, 0, events.types[i], events.notes[i], events.velocities[i]};
+            if (event.type == EventType::NoteOn) {
+                if (!roll(events.chances[i])) {
+                    // Skipped this time round, its NoteOff finds nothing sounding and is dropped too
+                    ++current.cursor;
+                    requeue(next.slot);
+                    continue;
+                }
+                if (!send(generator, event)) {
+                    // Queue full, the audio thread catches up and this gets retried on the next wakeup
+                    scheduled_song = position;
+                    finish();
+                    return false;
+                }
+                const uint64_t stop = std::min(current.instance.to_song(events.stop_ticks[i]), current.instance.end());
+                sounding.push_back({generator, event.note, output, output_at(tempo.sample_at(stop)), false, current.index});
+            } else {
+                // Only end notes this playback started (a note cut by a pause already got its NoteOff), matching
+                // on the stop time too so overlapping notes of the same pitch each end on their own
+                auto it = std::find_if(sounding.begin(), sounding.end(), [&](const SoundingNote& s) {
+                    return !s.off_scheduled && s.generator == generator && s.note == event.note && s.stop_output == event.time;
+                });
+                if (it != sounding.end()) {
+                    if (!send(generator, event)) {
+                        scheduled_song = position;
+                        finish();
+                        return false;
+                    }
+                    it->off_scheduled = true;
+                }
+            }
+            ++current.cursor;
+            requeue(next.slot);
+        }
+    }
+
+    void SequencerState::schedule(uint64_t now) {
+        // Forget notes whose NoteOff has already played
+        std::erase_if(sounding, [now](const SoundingNote& s) { return s.off_scheduled && s.stop_output < now; });
+
+        if (!playing) {
+            return;
+        }
+
+        // Laps the output has moved past are no longer needed to map it back to the song
+        while (anchors.size() > 1 && anchors[1].output <= now) {
+            retired = anchors.front();
+            has_retired = true;
+            anchors.erase(anchors.begin());
+        }
+
+        // One pass per lap, the wraparound lands on the exact output sample of loop.end wherever that falls in a block
+        const uint64_t horizon = now + lookahead;
+        for (;;) {
+            const uint64_t song_horizon = anchors.back().song + (horizon - anchors.back().output);
+            const bool wraps = loop.active() && scheduled_song <= loop.end && song_horizon >= loop.end;
+            if (!queue_until(wraps ? loop.end : song_horizon) || !wraps) {
+                break;
+            }
+            wrap(output_at(loop.end));
+        }
+
+        // A note edited away while it was sounding has no NoteOff in the new timeline, end it on its old stop time
+        for (auto& s : sounding) {
+            if (!s.off_scheduled && s.stop_output < output_at(scheduled_song)) {
+                s.off_scheduled = s.generator->Schedule({s.stop_output, 0, EventType::NoteOff, s.note, 0});
+            }
+        }
+    }
 } // Sequencing
-} // audio
\ No newline at end of file
+} // audio
@@ -1,85 +1,309 @@
 #ifndef SEQUENCERSTATE_H
 #define SEQUENCERSTATE_H
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include "Arrangement.h"
+#include "EditHistory.h"
+#include "EventTimeline.h"
 #include "Pattern.h"
+#include "TempoMap.h"
+#include "TimelineCompiler.h"
 #include "audio/AudioDefinitions.h"
+#include "audio/MpscQueue.h"
 
 namespace audio {
 namespace Sequencing {
 
+// Transport and sequencing. A lookahead thread walks the event timeline and queues timestamped events
+// into the generators ahead of time, the audio thread only reports how far it has rendered.
+// Transport positions (seek, loop, current sample) are song samples, notes are placed in ticks.
 class SequencerState {
 public:
-    SequencerState() = default;
-
-    void move_forward(uint64_t samples) {
-        if (is_playing){
-            current_sample += samples;
-            for (auto& pattern : patterns) {
-                pattern.update(current_sample);
-            }
+    // Song positions in samples, playback jumps back to start whenever it reaches end.
+    struct LoopRegion {
+        uint64_t start = 0;
+        uint64_t end = 0;
+        bool enabled = false;
+
+        [[nodiscard]] bool active() const {
+            return enabled && end >= start + min_loop_length;
         }
-    }
+    };
+
+    // Shorter loops are ignored, every lap costs a wraparound in the sequencer thread
+    static constexpr uint64_t min_loop_length = 64;
+
+    // Grid clip launches and stops snap to, in 4/4
+    enum class Quantize {
+        Beat,
+        Bar
+    };
+
+    // A pattern launched on a generator, see launch_clip
+    struct ClipSlot {
+        AudioGenerator* generator;
+        int pattern_id;
+        bool playing; // False while still waiting for its launch point
+    };
+
+    SequencerState();
+    ~SequencerState();
 
+    // Audio thread, once per block after rendering it.
     void processed(uint64_t samples) {
-        current_process_sample += samples;
+        current_process_sample.fetch_add(samples, std::memory_order_release);
     }
 
-    [[nodiscard]] uint64_t get_current_sample() const {
-        return current_sample;
-    }
+    // Song position at the output, in samples.
+    [[nodiscard]] uint64_t get_current_sample();
+    // Same position in ticks.
+    [[nodiscard]] uint64_t get_current_tick();
+    // Any thread, lock free: song position heard at an output sample, of the current loop lap or the ones just
+    // before and after it. Follows the transport within one sequencer wakeup (a few milliseconds).
+    [[nodiscard]] uint64_t get_song_at(uint64_t output) const;
+    // Song tick of a song position in samples.
+    [[nodiscard]] uint64_t get_tick_at_song(uint64_t song);
 
     [[nodiscard]] uint64_t get_current_process_sample() const {
-        return current_process_sample;
+        return current_process_sample.load(std::memory_order_acquire);
     }
 
-    void reset() {
-        current_sample = 0;
-        is_playing = false;
-        for (auto& callback : reset_callbacks) {
-            callback();
-        }
+    // Tempo at the playhead, lock free for the audio thread. Follows the tempo map within a few milliseconds.
+    [[nodiscard]] double get_samples_per_quarter() const {
+        return samples_per_quarter.load(std::memory_order_relaxed);
+    }
 
-        // Reset all patterns
-        for (auto& pattern : patterns) {
-            pattern.stop(); // Stop all note sequences in the pattern
-        }
+    void reset();
+    void start();
+    void pause();
+
+    // Moves the playhead to a song position, also while paused. Notes held across that position are chased:
+    // they restart there in the same step instead of staying silent until their next NoteOn.
+    void seek(uint64_t sample);
+
+    // Takes effect from the next wraparound the sequencer thread schedules. A playhead already past end
+    // plays on, it only loops once it is seeked or started before end again.
+    void set_loop(const LoopRegion& region);
+    [[nodiscard]] LoopRegion get_loop();
+
+    // While playing the change takes effect at the scheduling frontier and keeps the musical position there,
+    // notes already sounding end at the length they were started with.
+    void set_tempo_map(const TempoMap& map);
+    [[nodiscard]] TempoMap get_tempo_map();
+
+    // How far ahead of the output the sequencer thread schedules events, in samples.
+    void set_lookahead(uint64_t samples);
+
+    // Session mode, lock free so it can be called from the UI or a MIDI input thread. The pattern's events
+    // for that generator loop from the next quantize point the sequencer has not scheduled yet, replacing
+    // the clip playing on it there. Runs alongside the arrangement, on the same transport.
+    // Launch latency is at most the lookahead plus one quantize step. False when the command queue is full.
+    bool launch_clip(AudioGenerator* generator, int pattern_id, Quantize quantize = Quantize::Bar);
+    bool stop_clip(AudioGenerator* generator, Quantize quantize = Quantize::Bar);
+    [[nodiscard]] std::vector<ClipSlot> get_clips();
+
+    // Hold while changing patterns (or their notes) from outside the audio thread, the timeline compiler
+    // copies them under the same lock. The audio thread never touches patterns directly.
+    [[nodiscard]] std::unique_lock<std::mutex> lock_patterns() {
+        return std::unique_lock(patterns_mutex);
     }
 
-    void start() {
-        is_playing = true;
+    // Schedules a background rebuild of one pattern's part of the timeline, call after editing or removing it.
+    void mark_dirty(int pattern_id) {
+        compiler.mark_dirty(pattern_id);
     }
 
-    void pause() {
-        is_playing = false;
-        for (auto& pattern : patterns) {
-            pattern.pause(); // Stop all note sequences in the pattern
-        }
+    // Same for the arrangement, call after placing, moving or removing pattern instances.
+    void mark_arrangement_dirty() {
+        compiler.mark_arrangement_dirty();
     }
 
+    // Call before an edit, without holding lock_patterns(). Takes the undo step the edit can go back to.
+    void record_undo();
+
+    // Restore the step before (after) the current song and recompile what differs, false when there is none.
+    bool undo();
+    bool redo();
+
+    [[nodiscard]] bool can_undo();
+    [[nodiscard]] bool can_redo();
+
     [[nodiscard]] bool is_playing_state() const {
-        return is_playing;
+        return is_playing.load(std::memory_order_relaxed);
     }
 
-    [[nodiscard]] uint64_t get_current_slice() const {
-        return current_sample % SLICE_SIZE;
+    [[nodiscard]] uint64_t get_current_slice() {
+        return get_current_sample() % SLICE_SIZE;
     }
 
-    [[nodiscard]] uint64_t get_current_bucket() const {
-        return current_sample / SLICE_SIZE;
+    [[nodiscard]] uint64_t get_current_bucket() {
+        return get_current_sample() / SLICE_SIZE;
     }
 
     std::vector<std::function<void()>> reset_callbacks;
 
     std::vector<Pattern> patterns;
+    Arrangement arrangement; // Where the patterns play, a pattern without instances stays silent
     int id_counter = 0; // Counter for unique pattern IDs
 
 private:
-    uint64_t current_sample = 0;
-    uint64_t current_process_sample = 0;
-    bool is_playing = false;
+    enum class Command {
+        Start,
+        Pause,
+        Reset,
+        Seek
+    };
+
+    // Output sample from which the song plays on linearly from song
+    struct Anchor {
+        uint64_t song;
+        uint64_t output;
+    };
+
+    struct PendingCommand {
+        Command command;
+        uint64_t sample = 0; // Seek target
+    };
+
+    struct ClipCommand {
+        AudioGenerator* generator = nullptr;
+        int pattern_id = -1; // -1 stops the generator's clip
+        Quantize quantize = Quantize::Bar;
+    };
+
+    // A launched pattern, looping in laps of length ticks from start until stop
+    struct Clip {
+        AudioGenerator* generator;
+        int pattern_id;
+        const EventTimeline* events; // Of the current song, nullptr until the pattern is compiled
+        uint64_t start;
+        uint64_t length; // Whole bars
+        uint64_t stop;
+        uint32_t tag; // Marks its notes in sounding, above every arrangement index
+    };
+
+    static constexpr uint32_t no_instance = ~0u;
+    static constexpr uint32_t first_clip_tag = 1u << 31;
+
+    // A note the sequencer thread has scheduled, kept until its NoteOff has been played
+    struct SoundingNote {
+        AudioGenerator* generator;
+        uint8_t note;
+        uint64_t start_output; // Output samples
+        uint64_t stop_output;
+        bool off_scheduled;
+        uint32_t instance; // Arrangement index or clip tag it plays from, no_instance once the song has been swapped
+    };
+
+    // A pattern instance (or one lap of a clip) the scheduler is walking through
+    struct ActiveInstance {
+        uint32_t index; // Into song->arrangement, or a clip tag
+        PatternInstance instance;
+        const EventTimeline* events;
+        AudioGenerator* only; // A clip plays only its generator's events, nullptr plays all
+        size_t cursor; // Next event of its pattern
+    };
+
+    // Where an active instance is next due, ordered so the earliest (then NoteOff first, then the lower slot) comes out on top
+    struct DueInstance {
+        uint64_t tick;
+        EventType type;
+        uint32_t slot; // Into active
+        bool ends; // The instance itself ends here rather than one of its events
+
+        bool operator>(const DueInstance& other) const {
+            if (tick != other.tick) return tick > other.tick;
+            if (type != other.type) return type > other.type;
+            return slot > other.slot;
+        }
+    };
+
+    // A note held across a position, restarted there when playback starts or wraps around to it
+    struct HeldNote {
+        uint32_t instance;
+        uint32_t event;
+    };
+
+    std::mutex patterns_mutex;
+    TimelineCompiler compiler{patterns, arrangement, patterns_mutex};
+    EditHistory history; // Guarded by patterns_mutex
+
+    std::atomic<uint64_t> current_process_sample = 0;
+    std::atomic<bool> is_playing = false;
+    std::atomic<double> samples_per_quarter = SAMPLE_RATE / 2.0;
+
+    // Everything below is guarded by transport_mutex and only touched by the UI and the sequencer thread
+    std::mutex transport_mutex;
+    std::condition_variable_any transport_changed;
+    std::vector<PendingCommand> commands;
+    uint64_t lookahead = 4096;
+
+    bool playing = false; // As applied by the sequencer thread, is_playing is what the UI asked for
+    uint64_t anchor_song = 0; // Song position while stopped, playback starts from here
+    std::vector<Anchor> anchors; // While playing, one per loop lap that is still ahead of the output. back() is being scheduled
+    Anchor retired{}; // The last lap dropped from anchors, input stamped slightly in the past may still fall into it
+    bool has_retired = false;
+
+    // Copy of the laps for get_song_at, written by publish_laps under transport_mutex and read under a sequence lock
+    static constexpr size_t published_laps = 8;
+    std::atomic<uint32_t> laps_sequence = 0;
+    std::atomic<uint32_t> laps_count = 0; // 0 while stopped
+    std::atomic<uint64_t> laps_stopped_song = 0;
+    std::array<std::atomic<uint64_t>, published_laps> laps_song{};
+    std::array<std::atomic<uint64_t>, published_laps> laps_output{};
+    uint64_t scheduled_song = 0; // Events before this song position have been queued
+
+    TempoMap tempo;
+    LoopRegion loop;
+    std::vector<ActiveInstance> loop_active; // Instances and cursors at loop.start, cached so a wraparound is O(1)
+    std::vector<HeldNote> loop_chased; // Notes held across loop.start
+
+    MpscQueue<ClipCommand, 256> clip_commands; // Drained by the sequencer thread on every wakeup
+    std::vector<Clip> clips; // Sequencer thread, copied out under transport_mutex for get_clips
+    uint32_t next_clip_tag = first_clip_tag;
+
+    CompiledSong* song; // Owned, swapped for a recompiled one by the sequencer thread
+    std::vector<ActiveInstance> active;
+    std::vector<SoundingNote> sounding;
+    std::vector<AudioGenerator*> touched; // Every generator that has been sent events, for flushing
+    uint32_t chance_state = 0x9E3779B9; // Random state for step probabilities
+
+    // Scratch
+    std::vector<HeldNote> chased;
+    std::vector<uint32_t> found;
+    std::vector<DueInstance> due; // Min-heap over the active instances, rebuilt by every queue_until pass
+
+    std::jthread sequencer_thread;
+
+    void restore(EditHistory::Snapshot& snapshot);
+    void run(std::stop_token stop);
+    void apply(const PendingCommand& pending, uint64_t now);
+    void schedule(uint64_t now);
+    void publish_laps();
+    void begin_output(uint64_t now);
+    void stop_output(uint64_t now);
+    bool queue_until(uint64_t song_end);
+    [[nodiscard]] DueInstance due_at(uint32_t slot) const;
+    void wrap(uint64_t output);
+    void enter(uint64_t tick, std::vector<ActiveInstance>& instances, std::vector<HeldNote>& held);
+    void activate(uint64_t from_tick, uint64_t to_tick);
+    void activate_clips(uint64_t from_tick, uint64_t to_tick);
+    void apply_clip(const ClipCommand& command);
+    bool next_lap(ActiveInstance& lap);
+    bool cut(uint32_t instance, uint64_t output);
+    void chase(const std::vector<HeldNote>& held, uint64_t output);
+    void cache_loop_start();
+    bool send(AudioGenerator* generator, const NoteEvent& event);
+    bool roll(uint8_t chance);
+    [[nodiscard]] uint64_t song_at(uint64_t output) const;
+    [[nodiscard]] uint64_t output_at(uint64_t song) const;
 };
 
 } // Sequencing
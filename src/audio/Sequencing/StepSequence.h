@@ -0,0 +1,72 @@
+#ifndef STEPSEQUENCE_H
+#define STEPSEQUENCE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "TempoMap.h"
+#include "audio/AudioGenerator.h"
+
+namespace audio {
+namespace Sequencing {
+
+// One cell of the grid, velocity 0 is an empty step.
+struct Step {
+    uint8_t velocity = 0; // 0-127
+    uint8_t probability = 100; // Percent chance to play, rolled every time the step comes around
+    uint8_t ratchet = 1; // Retriggers within the step, each taking an equal part of it
+
+    [[nodiscard]] bool is_active() const { return velocity > 0 && probability > 0 && ratchet > 0; }
+
+    bool operator==(const Step& other) const = default;
+};
+
+// Drum machine style grid of steps by lanes, each lane one pitch on the sequence's generator. Compiled
+// straight into the pattern's event timeline next to its note sequences, without going through Notes,
+// so a dense grid costs only the events it plays.
+class StepSequence {
+public:
+    struct Lane {
+        uint8_t pitch = 36;
+        std::vector<Step> steps;
+
+        bool operator==(const Lane& other) const = default;
+    };
+
+    AudioGenerator *generator = nullptr;
+    uint32_t step_ticks = TempoMap::ticks_per_quarter / 4; // 16ths by default, ticks_per_quarter / 16 for 64ths
+    float gate = 0.5f; // How much of a step (or ratchet) each hit is held
+    std::vector<Lane> lanes;
+
+    [[nodiscard]] size_t step_count() const { return count; }
+
+    // Resizes every lane, new steps are empty.
+    void set_step_count(size_t steps) {
+        count = steps;
+        for (auto& lane : lanes) {
+            lane.steps.resize(steps);
+        }
+    }
+
+    Lane& add_lane(uint8_t pitch) {
+        lanes.push_back({pitch, std::vector<Step>(count)});
+        return lanes.back();
+    }
+
+    // Ticks one hit of a step with this many ratchets is held for, at least one.
+    [[nodiscard]] uint32_t hit_length(uint8_t ratchet) const {
+        const float length = gate * static_cast<float>(step_ticks) / static_cast<float>(ratchet);
+        return std::max<uint32_t>(static_cast<uint32_t>(length), 1);
+    }
+
+    bool operator==(const StepSequence& other) const = default;
+
+private:
+    size_t count = 16;
+};
+
+} // Sequencing
+} // audio
+
+#endif //STEPSEQUENCE_H
@@ -0,0 +1,98 @@
+#include "TempoMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+namespace Sequencing {
+    namespace {
+        constexpr double min_bpm = 1.0;
+        constexpr double max_bpm = 1000.0;
+    }
+
+    TempoMap::TempoMap(double bpm, double sample_rate) : sample_rate(sample_rate) {
+        changes.push_back({0, std::clamp(bpm, min_bpm, max_bpm)});
+        rebuild();
+    }
+
+    void TempoMap::set_tempo(uint64_t tick, double bpm) {
+        bpm = std::clamp(bpm, min_bpm, max_bpm);
+        auto it = std::lower_bound(changes.begin(), changes.end(), tick, [](const Change& c, uint64_t t) { return c.tick < t; });
+        if (it != changes.end() && it->tick == tick) {
+            it->bpm = bpm;
+        } else {
+            changes.insert(it, {tick, bpm});
+        }
+        rebuild();
+    }
+
+    void TempoMap::remove_change(uint64_t tick) {
+        if (tick == 0) {
+            return;
+        }
+        std::erase_if(changes, [tick](const Change& c) { return c.tick == tick; });
+        rebuild();
+    }
+
+    void TempoMap::set_sample_rate(double rate) {
+        sample_rate = rate;
+        rebuild();
+    }
+
+    void TempoMap::rebuild() {
+        segments.clear();
+        segments.reserve(changes.size());
+
+        double sample = 0.0;
+        for (std::size_t i = 0; i < changes.size(); ++i) {
+            const double samples_per_tick = sample_rate * 60.0 / (changes[i].bpm * static_cast<double>(ticks_per_quarter));
+            segments.push_back({changes[i].tick, sample, samples_per_tick});
+            if (i + 1 < changes.size()) {
+                sample += static_cast<double>(changes[i + 1].tick - changes[i].tick) * samples_per_tick;
+            }
+        }
+    }
+
+    std::size_t TempoMap::segment_for_tick(uint64_t tick) const {
+        // Last segment starting at or before tick, the first one starts at 0
+        auto it = std::upper_bound(segments.begin(), segments.end(), tick, [](uint64_t t, const Segment& s) { return t < s.tick; });
+        return static_cast<std::size_t>(it - segments.begin()) - 1;
+    }
+
+    uint64_t TempoMap::sample_in(const Segment& segment, uint64_t tick) {
+        return static_cast<uint64_t>(std::floor(segment.sample + static_cast<double>(tick - segment.tick) * segment.samples_per_tick));
+    }
+
+    double TempoMap::bpm_at(uint64_t tick) const {
+        return changes[segment_for_tick(tick)].bpm;
+    }
+
+    uint64_t TempoMap::sample_at(uint64_t tick) const {
+        return sample_in(segments[segment_for_tick(tick)], tick);
+    }
+
+    uint64_t TempoMap::tick_at(uint64_t sample) const {
+        // Last segment starting at or before sample, then invert its line and fix up the rounding
+        auto it = std::upper_bound(segments.begin(), segments.end(), static_cast<double>(sample), [](double s, const Segment& seg) { return s < seg.sample; });
+        const Segment& segment = *(it - 1);
+
+        uint64_t tick = segment.tick + static_cast<uint64_t>(std::max(0.0, std::ceil((static_cast<double>(sample) - segment.sample) / segment.samples_per_tick)));
+        while (tick > 0 && sample_at(tick - 1) >= sample) {
+            --tick;
+        }
+        while (sample_at(tick) < sample) {
+            ++tick;
+        }
+        return tick;
+    }
+
+    TempoMap::Cursor::Cursor(const TempoMap& map, uint64_t first_tick) : map(map), segment(map.segment_for_tick(first_tick)) {}
+
+    uint64_t TempoMap::Cursor::sample_at(uint64_t tick) {
+        while (segment + 1 < map.segments.size() && map.segments[segment + 1].tick <= tick) {
+            ++segment;
+        }
+        return sample_in(map.segments[segment], tick);
+    }
+} // Sequencing
+} // audio
@@ -0,0 +1,73 @@
+#ifndef TEMPOMAP_H
+#define TEMPOMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio/AudioDefinitions.h"
+
+namespace audio {
+namespace Sequencing {
+
+// Maps musical time (ticks) to song samples. Notes are stored in ticks, so a tempo or sample rate
+// change only rebuilds the segment table here instead of touching every note.
+class TempoMap {
+public:
+    static constexpr uint64_t ticks_per_quarter = 960;
+
+    struct Change {
+        uint64_t tick;
+        double bpm;
+    };
+
+    explicit TempoMap(double bpm = 120.0, double sample_rate = SAMPLE_RATE);
+
+    // Sets the tempo from tick until the next change, replacing a change already at that tick.
+    void set_tempo(uint64_t tick, double bpm);
+    // Drops the change at tick, the tempo at tick 0 always stays.
+    void remove_change(uint64_t tick);
+    void set_sample_rate(double rate);
+
+    [[nodiscard]] const std::vector<Change>& get_changes() const { return changes; }
+    [[nodiscard]] double get_sample_rate() const { return sample_rate; }
+    [[nodiscard]] double bpm_at(uint64_t tick) const;
+
+    // Song sample the tick falls on, rounded down.
+    [[nodiscard]] uint64_t sample_at(uint64_t tick) const;
+    // First tick whose sample_at() is at or after sample.
+    [[nodiscard]] uint64_t tick_at(uint64_t sample) const;
+
+    // Converts a rising run of ticks (the timeline in order) with a single binary search up front,
+    // gives exactly the same samples as sample_at().
+    class Cursor {
+    public:
+        Cursor(const TempoMap& map, uint64_t first_tick);
+        uint64_t sample_at(uint64_t tick);
+
+    private:
+        const TempoMap& map;
+        std::size_t segment;
+    };
+
+private:
+    // A constant tempo run, precomputed from the changes
+    struct Segment {
+        uint64_t tick;
+        double sample; // Song sample at tick, exact so segments do not accumulate rounding
+        double samples_per_tick;
+    };
+
+    std::vector<Change> changes; // Sorted by tick, the first one always at tick 0
+    std::vector<Segment> segments;
+    double sample_rate;
+
+    void rebuild();
+    [[nodiscard]] std::size_t segment_for_tick(uint64_t tick) const;
+    [[nodiscard]] static uint64_t sample_in(const Segment& segment, uint64_t tick);
+};
+
+} // Sequencing
+} // audio
+
+#endif //TEMPOMAP_H
@@ -0,0 +1,115 @@
+#include "TimelineCompiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace audio {
+namespace Sequencing {
+    TimelineCompiler::TimelineCompiler(const std::vector<Pattern>& patterns, const Arrangement& arrangement, std::mutex& patterns_mutex)
+        : patterns(patterns), arrangement(arrangement), patterns_mutex(patterns_mutex) {
+        thread = std::jthread([this](std::stop_token stop) { run(stop); });
+    }
+
+    TimelineCompiler::~TimelineCompiler() {
+        thread.request_stop();
+        if (thread.joinable()) {
+            thread.join();
+        }
+        delete published.exchange(nullptr);
+        free_retired();
+    }
+
+    void TimelineCompiler::mark_dirty(int pattern_id) {
+        {
+            std::lock_guard lock(dirty_mutex);
+            dirty.insert(pattern_id);
+        }
+        dirty_changed.notify_one();
+    }
+
+    void TimelineCompiler::mark_arrangement_dirty() {
+        {
+            std::lock_guard lock(dirty_mutex);
+            arrangement_dirty = true;
+        }
+        dirty_changed.notify_one();
+    }
+
+    CompiledSong* TimelineCompiler::adopt(CompiledSong* current) {
+        // Only this thread pushes to retired, so if there is room now there still is after the exchange
+        if (retired.full()) {
+            return current;
+        }
+        CompiledSong* next = published.exchange(nullptr, std::memory_order_acq_rel);
+        if (next == nullptr) {
+            return current;
+        }
+        retired.push(current);
+        return next;
+    }
+
+    void TimelineCompiler::free_retired() {
+        CompiledSong* song = nullptr;
+        while (retired.pop(song)) {
+            delete song;
+        }
+    }
+
+    void TimelineCompiler::run(std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            std::unordered_set<int> to_build;
+            bool reindex = false;
+            {
+                std::unique_lock lock(dirty_mutex);
+                // Wake up now and then regardless, so replaced songs do not linger
+                dirty_changed.wait_for(lock, stop, std::chrono::milliseconds(100), [this] { return !dirty.empty() || arrangement_dirty; });
+                to_build.swap(dirty);
+                std::swap(reindex, arrangement_dirty);
+            }
+
+            free_retired();
+            if (to_build.empty() && !reindex) {
+                continue;
+            }
+
+            // Copy the dirty patterns and the (small) instance list while holding the lock, compiling happens
+            // without it so edits stay responsive
+            std::vector<Pattern> copies;
+            std::vector<PatternInstance> instances;
+            {
+                std::lock_guard lock(patterns_mutex);
+                for (int id : to_build) {
+                    auto it = std::find_if(patterns.begin(), patterns.end(), [id](const Pattern& p) { return p.id == id; });
+                    if (it != patterns.end()) {
+                        copies.push_back(*it);
+                    }
+                }
+                instances = arrangement.instances;
+            }
+
+            for (int id : to_build) {
+                slices.erase(id);
+            }
+            for (const auto& pattern : copies) {
+                slices[pattern.id] = std::make_shared<const EventTimeline>(EventTimeline::compile(pattern));
+            }
+
+            auto* song = new CompiledSong();
+            std::vector<ArrangementIndex::Entry> entries;
+            entries.reserve(instances.size());
+            for (const auto& instance : instances) {
+                auto it = slices.find(instance.pattern_id);
+                entries.push_back({instance, it != slices.end() ? it->second.get() : nullptr});
+            }
+            song->arrangement = ArrangementIndex(std::move(entries));
+            for (const auto& [id, slice] : slices) {
+                song->slices.push_back(slice);
+                song->slice_patterns.push_back(id);
+            }
+
+            // Anything still in published was never seen by the sequencer thread, so it can go right away
+            delete published.exchange(song, std::memory_order_acq_rel);
+        }
+    }
+} // Sequencing
+} // audio
@@ -0,0 +1,82 @@
+#ifndef TIMELINECOMPILER_H
+#define TIMELINECOMPILER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <map>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "Arrangement.h"
+#include "EventTimeline.h"
+#include "Pattern.h"
+#include "audio/SpscQueue.h"
+
+namespace audio {
+namespace Sequencing {
+
+// What the sequencer thread plays, immutable once published.
+struct CompiledSong {
+    std::vector<std::shared_ptr<const EventTimeline>> slices; // Keeps the events alive, later songs share them
+    std::vector<int> slice_patterns; // Pattern id of each slice
+    ArrangementIndex arrangement;
+
+    // Compiled events of a pattern, nullptr when it has none (yet).
+    [[nodiscard]] const EventTimeline* find(int pattern_id) const {
+        for (size_t i = 0; i < slices.size(); ++i) {
+            if (slice_patterns[i] == pattern_id) {
+                return slices[i].get();
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Rebuilds the song on a background thread. Only the slices of patterns marked dirty are recompiled,
+// then the arrangement is indexed over them and the result is handed to the sequencer thread without locking.
+class TimelineCompiler {
+public:
+    TimelineCompiler(const std::vector<Pattern>& patterns, const Arrangement& arrangement, std::mutex& patterns_mutex);
+    ~TimelineCompiler();
+
+    TimelineCompiler(const TimelineCompiler&) = delete;
+    TimelineCompiler& operator=(const TimelineCompiler&) = delete;
+
+    // Queues a rebuild of one pattern's slice, also call it after removing a pattern.
+    void mark_dirty(int pattern_id);
+    // Queues a reindex after editing the arrangement.
+    void mark_arrangement_dirty();
+
+    // Sequencer thread, between scheduling passes. Returns the newest published song, or current when nothing
+    // changed. A replaced song is handed back to the compiler thread to be freed there.
+    CompiledSong* adopt(CompiledSong* current);
+
+private:
+    const std::vector<Pattern>& patterns;
+    const Arrangement& arrangement;
+    std::mutex& patterns_mutex;
+
+    std::mutex dirty_mutex;
+    std::condition_variable_any dirty_changed;
+    std::unordered_set<int> dirty;
+    bool arrangement_dirty = false;
+
+    // Owned by the compiler thread
+    std::map<int, std::shared_ptr<const EventTimeline>> slices;
+
+    std::atomic<CompiledSong*> published{nullptr};
+    SpscQueue<CompiledSong*, 16> retired;
+
+    std::jthread thread;
+
+    void run(std::stop_token stop);
+    void free_retired();
+};
+
+} // Sequencing
+} // audio
+
+#endif //TIMELINECOMPILER_H
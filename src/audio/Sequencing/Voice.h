@@ -1,7 +1,10 @@
 #ifndef VOICE_H
 #define VOICE_H
+#include <algorithm>
 #include <cstdint>
 
+#include "audio/rng.h"
+
 namespace audio::Sequencing {
 
     enum class AdsrState{
@@ -30,48 +33,59 @@ namespace audio::Sequencing {
         // New field to track amplitude at start of release
         float releaseStartAmplitude = 0.0f;
 
-        float process(uint64_t current_sample, uint64_t creation_time, bool* should_kill) {
-            switch (state) {
-                case AdsrState::Attack: {
-                    if (current_sample >= creation_time + attackTime) {
-                        state = AdsrState::Decay;
-                        currentAmplitude = 1.0f;
-                        return 1.0f;
+        // Fills out[0, frames) with the envelope for samples [start, start + frames). Each stage is written as one
+        // straight ramp, so the per-sample work has no branches and the kernels can vectorise it.
+        void render(float* out, int frames, uint64_t start, uint64_t creation_time, bool* should_kill) {
+            int f = 0;
+            while (f < frames) {
+                const uint64_t sample = start + f;
+                switch (state) {
+                    case AdsrState::Attack: {
+                        const uint64_t end = creation_time + attackTime;
+                        if (sample >= end) {
+                            state = AdsrState::Decay;
+                            continue;
+                        }
+                        const int n = stage_frames(sample, end, frames - f);
+                        ramp(out + f, n, 0.0f, 1.0f, sample - creation_time, attackTime, attackTension);
+                        f += n;
+                        break;
                     }
-                    float t = static_cast<float>(current_sample - creation_time) / attackTime;
-                    float a = lerp_tension(0.0f, 1.0f, t, attackTension);
-                    currentAmplitude = a;
-                    return a;
-                }
-                case AdsrState::Decay: {
-                    if (current_sample >= creation_time + attackTime + decayTime) {
-                        state = AdsrState::Sustain;
-                        currentAmplitude = sustainLevel;
-                        return sustainLevel;
+                    case AdsrState::Decay: {
+                        const uint64_t end = creation_time + attackTime + decayTime;
+                        if (sample >= end) {
+                            state = AdsrState::Sustain;
+                            continue;
+                        }
+                        const int n = stage_frames(sample, end, frames - f);
+                        ramp(out + f, n, 1.0f, sustainLevel, sample - (creation_time + attackTime), decayTime, decayTension);
+                        f += n;
+                        break;
                     }
-                    float t = static_cast<float>(current_sample - (creation_time + attackTime)) / decayTime;
-                    float a = lerp_tension(1.0f, sustainLevel, t, decayTension);
-                    currentAmplitude = a;
-                    return a;
-                }
-                case AdsrState::Sustain: {
-                    currentAmplitude = sustainLevel;
-                    return sustainLevel;
-                }
-                case AdsrState::Release: {
-                    if (current_sample >= creation_time + releaseTime) {
-                        *should_kill = true;
-                        currentAmplitude = 0.0f;
-                        return 0.0f;
+                    case AdsrState::Sustain: {
+                        fill(out + f, frames - f, sustainLevel);
+                        f = frames;
+                        break;
+                    }
+                    case AdsrState::Release: {
+                        const uint64_t end = creation_time + releaseTime;
+                        if (sample >= end) {
+                            *should_kill = true;
+                            fill(out + f, frames - f, 0.0f);
+                            f = frames;
+                            break;
+                        }
+                        const int n = stage_frames(sample, end, frames - f);
+                        ramp(out + f, n, releaseStartAmplitude, 0.0f, sample - creation_time, releaseTime, releaseTension);
+                        f += n;
+                        break;
                     }
-                    float t = static_cast<float>(current_sample - creation_time) / releaseTime;
-                    float a = lerp_tension(releaseStartAmplitude, 0.0f, t, releaseTension);
-                    currentAmplitude = a;
-                    return a;
                 }
             }
 
-            return 0.0f;
+            if (frames > 0) {
+                currentAmplitude = out[frames - 1];
+            }
         }
 
         void enterRelease(uint64_t current_sample) {
@@ -80,6 +94,25 @@ namespace audio::Sequencing {
         }
 
     private:
+        static int stage_frames(uint64_t sample, uint64_t end, int remaining) {
+            return static_cast<int>(std::min<uint64_t>(end - sample, static_cast<uint64_t>(remaining)));
+        }
+
+        // out[i] = shape(a -> b) at (offset + i) / length
+        static void ramp(float* out, int n, float a, float b, uint64_t offset, uint64_t length, float tension) {
+            const float base = static_cast<float>(offset);
+            const float inv_length = 1.0f / static_cast<float>(length);
+            for (int i = 0; i < n; ++i) {
+                out[i] = lerp_tension(a, b, (base + static_cast<float>(i)) * inv_length, tension);
+            }
+        }
+
+        static void fill(float* out, int n, float value) {
+            for (int i = 0; i < n; ++i) {
+                out[i] = value;
+            }
+        }
+
         static float lerp_tension(float a, float b, float t, float tension) {
             return a + (b - a) * t;
         }
@@ -94,6 +127,8 @@ namespace audio::Sequencing {
         int id{}; // Unique identifier for the voice, can be used to track it in a collection
         uint64_t creation_time{}; // Time when the voice was created
         AdsrEnvelope envelope {};
+        math::rng::Stream noise {}; // Per-voice white noise, seeded at note on
+
     };
 }
 
@@ -0,0 +1,64 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace audio {
+
+// Bounded single producer / single consumer ring, wait free on both ends so it can be used from the audio thread.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side, returns false when the queue is full.
+    bool push(const T& value) {
+        const size_t tail = write_index.load(std::memory_order_relaxed);
+        if (tail - read_index.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[tail & (Capacity - 1)] = value;
+        write_index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false when the queue is empty.
+    bool pop(T& out) {
+        const size_t head = read_index.load(std::memory_order_relaxed);
+        if (head == write_index.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = slots[head & (Capacity - 1)];
+        read_index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, the oldest element without removing it (nullptr when empty).
+    const T* front() const {
+        const size_t head = read_index.load(std::memory_order_relaxed);
+        if (head == write_index.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[head & (Capacity - 1)];
+    }
+
+    // Producer side, once false it stays false until the producer pushes again.
+    [[nodiscard]] bool full() const {
+        return write_index.load(std::memory_order_relaxed) - read_index.load(std::memory_order_acquire) == Capacity;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> read_index{0};
+    alignas(64) std::atomic<size_t> write_index{0};
+    std::array<T, Capacity> slots{};
+};
+
+} // audio
+
+#endif //SPSCQUEUE_H
@@ -2,21 +2,16 @@
 #define AUDIO_MATH_H
 
 #include <array>
+#include <bit>
 #include <cmath>
 #include <iostream>
 #include "AudioDefinitions.h"
+#include "fast_math.h"
+#include "rng.h"
 
 namespace audio {
 namespace math {
 
-inline float noise_buffer[NOISE_SAMPLES];
-
-static void init_noise() {
-    for (int i = 0; i < NOISE_SAMPLES; i++) {
-        noise_buffer[i] = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0f - 1.0f; // Generate noise in range [-1, 1]
-    }
-}
-
 static inline std::array<float,2> pan(const std::array<float,2>& in, float pan)
 {
     float left_gain  = (1.0f - pan) * 0.5f;
@@ -25,49 +20,45 @@ static inline std::array<float,2> pan(const std::array<float,2>& in, float pan)
              in[1] * right_gain };
 }
 
-static inline float generate_waveform(Waveform waveform, float phase)
+template <Waveform W>
+static inline float generate_waveform(float phase)
 {
     // First, fold phase into [0, 2π]
-    float phase_mod = fmodf(phase, 2.0f * M_PI);
-    if (phase_mod < 0.0f)
-        phase_mod += 2.0f * M_PI;
+    const float phase_mod = fast::wrap_phase(phase);
+
+    if constexpr (W == Waveform::Sine) {
+        // standard sine wave
+        return fast::sin(phase_mod);
+    } else if constexpr (W == Waveform::Square) {
+        // +1 for first half‑cycle, –1 for second half
+        return (phase_mod < fast::pi) ?  1.0f : -1.0f;
+    } else if constexpr (W == Waveform::Saw) {
+        // ramp from –1 at phase=0 to +1 at phase=2π
+        return (phase_mod * (1.0f / fast::pi)) - 1.0f;
+    } else if constexpr (W == Waveform::Triangle) {
+        // same shape as (2/π) * asin(sin(phase)), without the two libm calls
+        return fast::triangle(phase_mod);
+    } else if constexpr (W == Waveform::Noise) {
+        // Stateless fallback keyed on the phase, the voice kernels draw from the voice's own noise stream instead
+        return rng::bipolar(0, std::bit_cast<uint32_t>(phase_mod));
+    } else {
+        // safety fallback
+        return 0.0f;
+    }
+}
 
-    float result = 0.0f;
+// Runtime variant, prefer the templated one (or the generator kernels) in per-sample loops.
+static inline float generate_waveform(Waveform waveform, float phase)
+{
     switch (waveform)
     {
-        case Waveform::Sine:
-            // standard sine wave
-            result = sinf(phase);
-            break;
-
-        case Waveform::Square:
-            // +1 for first half‑cycle, –1 for second half
-            result = (phase_mod < M_PI) ?  1.0f : -1.0f;
-            break;
-
-        case Waveform::Saw:
-            // ramp from –1 at phase=0 to +1 at phase=2π
-            result = (phase_mod / M_PI) - 1.0f;
-            break;
-
-        case Waveform::Triangle:
-            // triangle via arcsine of sine
-            result = (2.0f / M_PI) * asinf(sinf(phase));
-            break;
-
-        case Waveform::Noise:
-        {
-            result = noise_buffer[static_cast<int>(phase_mod * NOISE_SAMPLES / (2.0f * M_PI)) % NOISE_SAMPLES];
-            break;
-        }
-
-        default:
-            // safety fallback
-            result = 0.0f;
-            break;
+        case Waveform::Sine:     return generate_waveform<Waveform::Sine>(phase);
+        case Waveform::Square:   return generate_waveform<Waveform::Square>(phase);
+        case Waveform::Saw:      return generate_waveform<Waveform::Saw>(phase);
+        case Waveform::Triangle: return generate_waveform<Waveform::Triangle>(phase);
+        case Waveform::Noise:    return generate_waveform<Waveform::Noise>(phase);
+        default:                 return 0.0f;
     }
-
-    return result;
 }
 
 }
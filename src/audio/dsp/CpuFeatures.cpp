@@ -0,0 +1,16 @@
+#include "CpuFeatures.h"
+
+namespace audio::dsp {
+    IsaLevel detect_isa() {
+#if DSP_ISA_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")) {
+            return IsaLevel::Avx512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return IsaLevel::Avx2;
+        }
+#endif
+        return IsaLevel::Baseline;
+    }
+}
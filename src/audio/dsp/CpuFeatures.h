@@ -0,0 +1,37 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+// Only GCC/Clang on x86 can build per-function ISA variants, everything else runs the baseline kernels.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DSP_ISA_DISPATCH 1
+#define DSP_TARGET_AVX2 __attribute__((target("avx2,fma"), flatten))
+#define DSP_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx2,fma"), flatten))
+#define DSP_TARGET_BASELINE __attribute__((flatten))
+#else
+#define DSP_ISA_DISPATCH 0
+#define DSP_TARGET_AVX2
+#define DSP_TARGET_AVX512
+#define DSP_TARGET_BASELINE
+#endif
+
+namespace audio::dsp {
+    enum class IsaLevel {
+        Baseline, // SSE2 on x86-64, or whatever the compiler targets elsewhere
+        Avx2,
+        Avx512
+    };
+
+    // Queries CPUID for the widest instruction set the DSP kernels can use on this machine.
+    IsaLevel detect_isa();
+
+    constexpr const char* to_string(IsaLevel level) {
+        switch (level) {
+            case IsaLevel::Baseline: return "Baseline";
+            case IsaLevel::Avx2:     return "AVX2";
+            case IsaLevel::Avx512:   return "AVX-512";
+            default:                 return "Unknown";
+        }
+    }
+}
+
+#endif //CPUFEATURES_H
@@ -0,0 +1,90 @@
+#include "DspKernels.h"
+
+#include "audio/audio_math.h"
+
+namespace audio::dsp {
+    namespace {
+        using Generators::kernels::BlockParams;
+
+        inline void mix_master(float *out, const float *in, int frames, float pan, float volume) {
+            const auto gains = audio::math::pan({volume, volume}, pan);
+            for (int f = 0; f < frames; ++f) {
+                out[f * 2] = in[f * 2] * gains[0];
+                out[f * 2 + 1] = in[f * 2 + 1] * gains[1];
+            }
+        }
+
+        // Every variant flattens the generic kernel into a function compiled for its own instruction set,
+        // so the inlined copies get vectorised for that ISA while the shared out-of-line code stays baseline.
+        template <Waveform W, int Channels>
+        struct BaselineVoice {
+            DSP_TARGET_BASELINE static bool run(Sequencing::Voice& voice, const BlockParams& params) {
+                return Generators::kernels::render_voice<W, Channels>(voice, params);
+            }
+        };
+
+        DSP_TARGET_BASELINE void mix_master_baseline(float *out, const float *in, int frames, float pan, float volume) {
+            mix_master(out, in, frames, pan, volume);
+        }
+
+        const KernelSet baseline_kernels{
+            IsaLevel::Baseline,
+            Generators::kernels::make_table<BaselineVoice>(),
+            &mix_master_baseline
+        };
+
+#if DSP_ISA_DISPATCH
+        template <Waveform W, int Channels>
+        struct Avx2Voice {
+            DSP_TARGET_AVX2 static bool run(Sequencing::Voice& voice, const BlockParams& params) {
+                return Generators::kernels::render_voice<W, Channels>(voice, params);
+            }
+        };
+
+        DSP_TARGET_AVX2 void mix_master_avx2(float *out, const float *in, int frames, float pan, float volume) {
+            mix_master(out, in, frames, pan, volume);
+        }
+
+        const KernelSet avx2_kernels{
+            IsaLevel::Avx2,
+            Generators::kernels::make_table<Avx2Voice>(),
+            &mix_master_avx2
+        };
+
+        template <Waveform W, int Channels>
+        struct Avx512Voice {
+            DSP_TARGET_AVX512 static bool run(Sequencing::Voice& voice, const BlockParams& params) {
+                return Generators::kernels::render_voice<W, Channels>(voice, params);
+            }
+        };
+
+        DSP_TARGET_AVX512 void mix_master_avx512(float *out, const float *in, int frames, float pan, float volume) {
+            mix_master(out, in, frames, pan, volume);
+        }
+
+        const KernelSet avx512_kernels{
+            IsaLevel::Avx512,
+            Generators::kernels::make_table<Avx512Voice>(),
+            &mix_master_avx512
+        };
+#endif
+
+        // Written once before the audio device starts, only read afterward.
+        const KernelSet* active_kernels = &baseline_kernels;
+    }
+
+    void select_kernels(IsaLevel level) {
+#if DSP_ISA_DISPATCH
+        switch (level) {
+            case IsaLevel::Avx512: active_kernels = &avx512_kernels; return;
+            case IsaLevel::Avx2:   active_kernels = &avx2_kernels; return;
+            default: break;
+        }
+#endif
+        active_kernels = &baseline_kernels;
+    }
+
+    const KernelSet& kernels() {
+        return *active_kernels;
+    }
+}
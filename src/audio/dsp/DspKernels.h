@@ -0,0 +1,29 @@
+#ifndef DSPKERNELS_H
+#define DSPKERNELS_H
+
+#include "CpuFeatures.h"
+#include "audio/Generators/WaveformKernels.h"
+
+namespace audio::dsp {
+    // Applies master pan and volume to an interleaved stereo block, in may alias out.
+    using MixMasterFn = void (*)(float *out, const float *in, int frames, float pan, float volume);
+
+    // One set of hot path kernels, all compiled for the same instruction set.
+    struct KernelSet {
+        IsaLevel isa;
+        Generators::kernels::RenderVoiceTable oscillators;
+        MixMasterFn mix_master;
+
+        [[nodiscard]] Generators::kernels::RenderVoiceFn oscillator(Waveform waveform, int channels) const {
+            return Generators::kernels::select(oscillators, waveform, channels);
+        }
+    };
+
+    // Picks the kernel set for the given level (falling back to the widest one that was built),
+    // call once at startup before the audio device starts pulling blocks.
+    void select_kernels(IsaLevel level);
+
+    [[nodiscard]] const KernelSet& kernels();
+}
+
+#endif //DSPKERNELS_H
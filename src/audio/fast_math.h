@@ -0,0 +1,128 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <bit>
+#include <cstdint>
+
+// Branch free approximations for the per-sample and per-note paths, everything here is plain arithmetic
+// so it inlines into the DSP kernels and vectorises for whichever ISA they were built for.
+// The error bounds below were measured against libm (double precision) over the ranges given.
+namespace audio::math::fast {
+    constexpr float pi = 3.14159265358979323846f;
+    constexpr float two_pi = 2.0f * pi;
+    constexpr float inv_two_pi = 1.0f / two_pi;
+
+    // floor() for |x| < 2^31, without a libm call.
+    constexpr float floor(float x) {
+        float truncated = static_cast<float>(static_cast<int32_t>(x));
+        return truncated - (truncated > x ? 1.0f : 0.0f);
+    }
+
+    // Largest float below 2π, the top of wrap_phase's range.
+    constexpr float below_two_pi = std::bit_cast<float>(std::bit_cast<uint32_t>(two_pi) - 1u);
+
+    // Folds any phase into [0, 2π), replaces fmodf(phase, 2π) for |phase| < 2^24.
+    // Exact up to the rounding of phase itself (1e-6 at 2π, 6e-5 at 1000).
+    constexpr float wrap_phase(float phase) {
+        const float wrapped = phase - two_pi * floor(phase * inv_two_pi);
+        // Tiny negative phases round up to exactly 2π (and phases just below 2π can land just below 0)
+        const float clamped = wrapped > below_two_pi ? below_two_pi : wrapped;
+        return clamped < 0.0f ? 0.0f : clamped;
+    }
+
+    // sin(x), max absolute error 3e-7 for |x| <= 20 and 1.5e-6 for |x| <= 2^16.
+    constexpr float sin(float x) {
+        // Reduce to [-π, π] (2π split in two so k * 2π stays exact), then mirror into [-π/2, π/2]
+        const float k = floor(x * inv_two_pi + 0.5f);
+        x = (x - k * 6.28125f) - k * 1.9353071795864769e-3f;
+        if (x > 0.5f * pi) x = pi - x;
+        if (x < -0.5f * pi) x = -pi - x;
+
+        const float x2 = x * x;
+        // Taylor polynomial up to x^11, the x^13 term it drops is at most 6e-8 on [-π/2, π/2], so the 3e-7
+        // checked by tests/fast_math_test.cpp is float rounding and the range reduction
+        float p = -2.5052108385e-8f;
+        p = p * x2 + 2.7557319224e-6f;
+        p = p * x2 - 1.9841269841e-4f;
+        p = p * x2 + 8.3333333333e-3f;
+        p = p * x2 - 1.6666666667e-1f;
+        return x + x * x2 * p;
+    }
+
+    // cos(x), max absolute error 4e-6 for |x| <= 100, the π/2 shift rounds in float.
+    constexpr float cos(float x) {
+        return sin(x + 0.5f * pi);
+    }
+
+    // 2^x, max relative error 2e-7 for x in [-126, 127], clamped outside of it.
+    constexpr float exp2(float x) {
+        if (x < -126.0f) x = -126.0f;
+        if (x > 127.0f) x = 127.0f;
+
+        const float xi = floor(x);
+        const float f = x - xi; // [0, 1)
+
+        // Polynomial for 2^f on [0, 1)
+        float p = 1.8937541e-3f;
+        p = p * f + 8.9495904e-3f;
+        p = p * f + 5.5860337e-2f;
+        p = p * f + 2.4014182e-1f;
+        p = p * f + 6.9315449e-1f;
+        p = p * f + 9.9999990e-1f;
+
+        const auto exponent = static_cast<uint32_t>(static_cast<int32_t>(xi) + 127) << 23;
+        return p * std::bit_cast<float>(exponent);
+    }
+
+    // log2(x), max absolute error 6e-7 for x in [2^-16, 2^16] and within 1 ulp of the result for any other
+    // normal positive x. No special handling of 0, inf or nan.
+    constexpr float log2(float x) {
+        const auto bits = std::bit_cast<uint32_t>(x);
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127;
+        float m = std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u); // [1, 2)
+
+        // Recentre the mantissa around 1 so the series below converges quickly
+        if (m > 1.41421356f) {
+            m *= 0.5f;
+            exponent += 1;
+        }
+
+        // log2(m) = 2/ln2 * atanh(t), with t = (m - 1) / (m + 1) and |t| <= 0.172
+        const float t = (m - 1.0f) / (m + 1.0f);
+        const float t2 = t * t;
+        float p = 1.0f / 9.0f;
+        p = p * t2 + 1.0f / 7.0f;
+        p = p * t2 + 1.0f / 5.0f;
+        p = p * t2 + 1.0f / 3.0f;
+        p = p * t2 + 1.0f;
+        return static_cast<float>(exponent) + 2.8853900818f * t * p;
+    }
+
+    // tanh(x), max absolute error 2e-7 for all finite x.
+    constexpr float tanh(float x) {
+        // tanh(x) = 1 - 2 / (e^2x + 1), e^2x = 2^(2x / ln2)
+        if (x > 9.0f) return 1.0f;
+        if (x < -9.0f) return -1.0f;
+        return 1.0f - 2.0f / (exp2(2.8853900818f * x) + 1.0f);
+    }
+
+    // Frequency ratio for a detune in cents, max relative error 2.5e-7 (well below 0.001 cents).
+    constexpr float cents_to_ratio(float cents) {
+        return exp2(cents * (1.0f / 1200.0f));
+    }
+
+    // Frequency ratio for a detune in semitones, same bound as cents_to_ratio.
+    constexpr float semitones_to_ratio(float semitones) {
+        return exp2(semitones * (1.0f / 12.0f));
+    }
+
+    // Naive triangle wave in [-1, 1], identical to (2/π) * asin(sin(phase)) for phase in [0, 2π).
+    constexpr float triangle(float phase) {
+        float t = phase * inv_two_pi + 0.25f;
+        t -= floor(t);
+        const float d = t - 0.5f;
+        return 1.0f - 4.0f * (d < 0.0f ? -d : d);
+    }
+}
+
+#endif //FAST_MATH_H
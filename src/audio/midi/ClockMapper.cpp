@@ -0,0 +1,93 @@
+#include "ClockMapper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace audio {
+namespace midi {
+    double ClockMapper::host_now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void ClockMapper::observe(double host_seconds, uint64_t block_start, uint32_t frames) {
+        hosts[observed % window] = host_seconds;
+        samples[observed % window] = static_cast<double>(block_start);
+        ++observed;
+
+        const size_t count = std::min(observed, window);
+        if (count < min_observations) {
+            return;
+        }
+
+        // Centred sums, so the large absolute times do not cost precision
+        double mean_host = 0.0;
+        double mean_sample = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            mean_host += hosts[i];
+            mean_sample += samples[i];
+        }
+        mean_host /= static_cast<double>(count);
+        mean_sample /= static_cast<double>(count);
+
+        double covariance = 0.0;
+        double variance = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            const double host = hosts[i] - mean_host;
+            covariance += host * (samples[i] - mean_sample);
+            variance += host * host;
+        }
+
+        // Real clocks drift by parts per million, anything far off the nominal rate is a stalled or bursty callback
+        double fitted = variance > 0.0 ? covariance / variance : SAMPLE_RATE;
+        if (!std::isfinite(fitted)) {
+            fitted = SAMPLE_RATE;
+        }
+        fitted = std::clamp(fitted, SAMPLE_RATE * 0.99, SAMPLE_RATE * 1.01);
+
+        sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        anchor_host.store(mean_host, std::memory_order_relaxed);
+        anchor_sample.store(mean_sample, std::memory_order_relaxed);
+        rate.store(fitted, std::memory_order_relaxed);
+        latency.store(frames, std::memory_order_relaxed);
+        sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    bool ClockMapper::sample_at(double host_seconds, uint64_t& sample) const {
+        double host = 0.0;
+        double position = 0.0;
+        double samples_per_second = 0.0;
+        uint32_t delay = 0;
+        uint32_t before = 0;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            host = anchor_host.load(std::memory_order_relaxed);
+            position = anchor_sample.load(std::memory_order_relaxed);
+            samples_per_second = rate.load(std::memory_order_relaxed);
+            delay = latency.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((before & 1) != 0 || before != sequence.load(std::memory_order_relaxed));
+
+        if (before == 0) {
+            return false; // Nothing published yet
+        }
+        const double mapped = position + (host_seconds - host) * samples_per_second + delay;
+        sample = mapped > 0.0 ? static_cast<uint64_t>(std::llround(mapped)) : 0;
+        return true;
+    }
+
+    double DeviceClock::host_time(double delta_seconds, double arrival) {
+        clock += std::max(delta_seconds, 0.0);
+        const double delay = arrival - clock;
+        if (!synced) {
+            offset = delay;
+            synced = true;
+        } else {
+            offset = std::min(delay, offset + drift_allowance * (arrival - last_arrival));
+        }
+        last_arrival = arrival;
+        return clock + offset;
+    }
+} // midi
+} // audio
@@ -0,0 +1,66 @@
+#ifndef CLOCKMAPPER_H
+#define CLOCKMAPPER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio/AudioDefinitions.h"
+
+namespace audio {
+namespace midi {
+
+// Maps host time to positions on the audio output sample clock. The audio callback records its host time and
+// first sample once per block, a least squares line through the recent blocks smooths out callback jitter and
+// its slope follows the drift between the sound card and the host clock.
+class ClockMapper {
+public:
+    static constexpr size_t window = 64; // Blocks in the fit
+    static constexpr size_t min_observations = 8;
+
+    // Seconds on the steady clock, the host time every mapping is expressed in.
+    [[nodiscard]] static double host_now();
+
+    // Audio thread, at the start of every block.
+    void observe(double host_seconds, uint64_t block_start, uint32_t frames);
+
+    // Any thread: the output sample at which something that happened at host_seconds can first be played, a
+    // block after the sample that was playing then so every event sees the same latency. False until the
+    // audio callback ran for a few blocks.
+    [[nodiscard]] bool sample_at(double host_seconds, uint64_t& sample) const;
+
+private:
+    // Audio thread only
+    std::array<double, window> hosts{};
+    std::array<double, window> samples{};
+    size_t observed = 0;
+
+    // The published fit, sample = anchor_sample + (host - anchor_host) * rate, under a sequence lock
+    std::atomic<uint32_t> sequence = 0;
+    std::atomic<double> anchor_host = 0.0;
+    std::atomic<double> anchor_sample = 0.0;
+    std::atomic<double> rate = SAMPLE_RATE;
+    std::atomic<uint32_t> latency = 0;
+};
+
+// Turns one input port's driver timestamps, seconds since its previous message, into host time. The offset
+// between the two clocks is the smallest delivery delay seen so far, allowed to creep up slowly so drift
+// between the clocks cannot leave it stale. Only used from that port's input thread.
+class DeviceClock {
+public:
+    static constexpr double drift_allowance = 1e-4; // Seconds the offset may grow per second
+
+    [[nodiscard]] double host_time(double delta_seconds, double arrival);
+
+private:
+    double clock = 0.0; // Sum of the deltas
+    double offset = 0.0;
+    double last_arrival = 0.0;
+    bool synced = false;
+};
+
+} // midi
+} // audio
+
+#endif //CLOCKMAPPER_H
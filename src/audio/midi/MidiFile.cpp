@@ -0,0 +1,542 @@
+#include "MidiFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <memory>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace audio {
+namespace midi {
+    namespace {
+        void fail(std::string* error, const std::string& message) {
+            if (error) {
+                *error = message;
+            }
+        }
+
+        // Read only view of a whole file, unmapped when it goes out of scope
+        class MappedFile {
+        public:
+            explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+                file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) {
+                    return;
+                }
+                LARGE_INTEGER file_size{};
+                if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+                    return;
+                }
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping == nullptr) {
+                    return;
+                }
+                data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                size = data ? static_cast<size_t>(file_size.QuadPart) : 0;
+#else
+                descriptor = open(path.c_str(), O_RDONLY);
+                struct stat info{};
+                if (descriptor < 0 || fstat(descriptor, &info) != 0 || info.st_size == 0) {
+                    return;
+                }
+                void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (mapped == MAP_FAILED) {
+                    return;
+                }
+                madvise(mapped, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL); // One front to back pass
+                data = static_cast<const uint8_t*>(mapped);
+                size = static_cast<size_t>(info.st_size);
+#endif
+            }
+
+            ~MappedFile() {
+#ifdef _WIN32
+                if (data) UnmapViewOfFile(data);
+                if (mapping) CloseHandle(mapping);
+                if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+                if (data) munmap(const_cast<uint8_t*>(data), size);
+                if (descriptor >= 0) close(descriptor);
+#endif
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            [[nodiscard]] bool is_open() const { return data != nullptr; }
+            [[nodiscard]] std::span<const uint8_t> bytes() const { return {data, size}; }
+
+        private:
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+#ifdef _WIN32
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#else
+            int descriptor = -1;
+#endif
+        };
+
+        // Cursor over the mapped bytes, every read is bounds checked and sets failed instead of reading past the end
+        struct Reader {
+            const uint8_t* position;
+            const uint8_t* end;
+            bool failed = false;
+
+            [[nodiscard]] size_t remaining() const { return static_cast<size_t>(end - position); }
+
+            uint8_t byte() {
+                if (position == end) {
+                    failed = true;
+                    return 0;
+                }
+                return *position++;
+            }
+
+            uint32_t big_endian(int bytes) {
+                uint32_t value = 0;
+                for (int i = 0; i < bytes; ++i) {
+                    value = (value << 8) | byte();
+                }
+                return value;
+            }
+
+            // Variable length quantity, at most four bytes
+            uint32_t vlq() {
+                uint32_t value = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const uint8_t next = byte();
+                    value = (value << 7) | (next & 0x7F);
+                    if ((next & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                failed = true;
+                return value;
+            }
+
+            void skip(size_t bytes) {
+                if (bytes > remaining()) {
+                    failed = true;
+                    position = end;
+                    return;
+                }
+                position += bytes;
+            }
+        };
+
+        // A NoteOn still waiting for its NoteOff
+        struct Open {
+            uint64_t tick = 0;
+            uint32_t index = 0; // Of its note, added with the NoteOn so the notes come out sorted by start
+            bool held = false;
+        };
+
+        // Notes of one file track, split by channel for format 0 files
+        struct TrackParser {
+            std::array<std::vector<Sequencing::Note>, 16> notes;
+            std::array<std::array<Open, 128>, 16> open{};
+            std::string name;
+            uint16_t division = 1;
+            uint64_t end = 0; // Tick of the track's last event
+
+            [[nodiscard]] uint32_t rescale(uint64_t tick) const {
+                const uint64_t scaled = tick * Sequencing::TempoMap::ticks_per_quarter / division;
+                return static_cast<uint32_t>(std::min<uint64_t>(scaled, UINT32_MAX));
+            }
+
+            void note_off(uint8_t channel, uint8_t key, uint64_t tick) {
+                Open& held = open[channel][key];
+                if (!held.held) {
+                    return;
+                }
+                Sequencing::Note& note = notes[channel][held.index];
+                note.length = std::max<uint32_t>(rescale(tick) - note.tick, 1);
+                held.held = false;
+            }
+
+            void note_on(uint8_t channel, uint8_t key, uint8_t velocity, uint64_t tick) {
+                note_off(channel, key, tick); // Retriggering a held note ends it
+                Sequencing::Note note;
+                note.tick = rescale(tick);
+                note.pitch = key;
+                note.velocity = velocity;
+                open[channel][key] = {tick, static_cast<uint32_t>(notes[channel].size()), true};
+                notes[channel].push_back(note);
+            }
+        };
+
+        bool parse_track(Reader& track, TrackParser& parser, MidiFile& file, std::string* error) {
+            uint64_t& tick = parser.end;
+            uint8_t running = 0;
+            while (track.remaining() > 0 && !track.failed) {
+                tick += track.vlq();
+                uint8_t status = track.byte();
+                uint8_t first = 0;
+                if (status < 0x80) {
+                    // Running status, the byte was already the first data byte
+                    if (running == 0) {
+                        fail(error, "Data byte without a running status");
+                        return false;
+                    }
+                    first = status;
+                    status = running;
+                } else if (status < 0xF0) {
+                    running = status;
+                    first = track.byte();
+                }
+
+                const uint8_t channel = status & 0x0F;
+                switch (status & 0xF0) {
+                    case 0x80:
+                        track.byte();
+                        parser.note_off(channel, first & 0x7F, tick);
+                        break;
+                    case 0x90: {
+                        const uint8_t velocity = track.byte() & 0x7F;
+                        if (velocity == 0) {
+                            parser.note_off(channel, first & 0x7F, tick);
+                        } else {
+                            parser.note_on(channel, first & 0x7F, velocity, tick);
+                        }
+                        break;
+                    }
+                    case 0xA0:
+                    case 0xB0:
+                    case 0xE0:
+                        track.byte();
+                        break;
+                    case 0xC0:
+                    case 0xD0:
+                        break; // Their single data byte was read above
+                    default:
+                        if (status == 0xFF) {
+                            const uint8_t type = track.byte();
+                            const uint32_t length = track.vlq();
+                            if (length > track.remaining()) {
+                                fail(error, "Meta event runs past the end of its track");
+                                return false;
+                            }
+                            if (type == 0x51 && length == 3) {
+                                const uint32_t microseconds = track.big_endian(3);
+                                if (microseconds > 0) {
+                                    file.tempo.push_back({parser.rescale(tick), 60'000'000.0 / microseconds});
+                                }
+                            } else if (type == 0x03 && parser.name.empty()) {
+                                parser.name.assign(reinterpret_cast<const char*>(track.position), length);
+                                track.skip(length);
+                            } else if (type == 0x2F) {
+                                track.skip(length);
+                                return true; // End of track
+                            } else {
+                                track.skip(length);
+                            }
+                        } else if (status == 0xF0 || status == 0xF7) {
+                            track.skip(track.vlq()); // System exclusive
+                        } else {
+                            fail(error, "Unsupported system message in track");
+                            return false;
+                        }
+                        break;
+                }
+            }
+            if (track.failed) {
+                fail(error, "Track ends in the middle of an event");
+                return false;
+            }
+            return true;
+        }
+
+        void put_big_endian(std::vector<uint8_t>& out, uint32_t value, int bytes) {
+            for (int i = bytes - 1; i >= 0; --i) {
+                out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+            }
+        }
+
+        void put_vlq(std::vector<uint8_t>& out, uint32_t value) {
+            uint8_t bytes[5];
+            int count = 0;
+            do {
+                bytes[count++] = value & 0x7F;
+                value >>= 7;
+            } while (value != 0);
+            while (count > 1) {
+                out.push_back(bytes[--count] | 0x80);
+            }
+            out.push_back(bytes[0]);
+        }
+
+        // Longest delta time a four byte variable length quantity holds
+        constexpr uint64_t max_delta = 0x0FFFFFFF;
+
+        // Bridges a gap too long for one delta with empty text events, returns what is left of it for the
+        // next event's delta. The text events end any running status.
+        uint64_t bridge_gap(std::vector<uint8_t>& out, uint64_t delta) {
+            while (delta > max_delta) {
+                put_vlq(out, static_cast<uint32_t>(max_delta));
+                out.insert(out.end(), {0xFF, 0x01, 0x00});
+                delta -= max_delta;
+            }
+            return delta;
+        }
+
+        // Writes the chunk header, the length is patched in once the track is complete
+        size_t begin_track(std::vector<uint8_t>& out) {
+            out.insert(out.end(), {'M', 'T', 'r', 'k', 0, 0, 0, 0});
+            return out.size();
+        }
+
+        void end_track(std::vector<uint8_t>& out, size_t start) {
+            out.insert(out.end(), {0x00, 0xFF, 0x2F, 0x00});
+            const auto length = static_cast<uint32_t>(out.size() - start);
+            for (int i = 0; i < 4; ++i) {
+                out[start - 4 + i] = static_cast<uint8_t>(length >> (8 * (3 - i)));
+            }
+        }
+    }
+
+    std::optional<MidiFile> parse_smf(std::span<const uint8_t> data, std::string* error) {
+        Reader reader{data.data(), data.data() + data.size()};
+        if (reader.remaining() < 14 || reader.big_endian(4) != 0x4D546864 /* MThd */) {
+            fail(error, "Not a Standard MIDI File");
+            return std::nullopt;
+        }
+        const uint32_t header_length = reader.big_endian(4);
+        const uint16_t format = static_cast<uint16_t>(reader.big_endian(2));
+        const uint16_t track_count = static_cast<uint16_t>(reader.big_endian(2));
+        const uint16_t division = static_cast<uint16_t>(reader.big_endian(2));
+        if (header_length < 6 || format > 2) {
+            fail(error, "Malformed MIDI file header");
+            return std::nullopt;
+        }
+        if (division == 0 || (division & 0x8000)) {
+            fail(error, "SMPTE time division is not supported");
+            return std::nullopt;
+        }
+        reader.skip(header_length - 6);
+
+        MidiFile file;
+        auto parser = std::make_unique<TrackParser>(); // 8 KB of held notes, kept off the stack
+        for (uint16_t t = 0; t < track_count && reader.remaining() >= 8 && !reader.failed; ) {
+            const uint32_t type = reader.big_endian(4);
+            const uint32_t length = reader.big_endian(4);
+            if (length > reader.remaining()) {
+                fail(error, "Track chunk runs past the end of the file");
+                return std::nullopt;
+            }
+            Reader track{reader.position, reader.position + length};
+            reader.skip(length);
+            if (type != 0x4D54726B /* MTrk */) {
+                continue; // Unknown chunks are skipped, as the format asks
+            }
+            ++t;
+
+            *parser = TrackParser{};
+            parser->division = division;
+            if (!parse_track(track, *parser, file, error)) {
+                return std::nullopt;
+            }
+            // Notes still held at the end of the track end there
+            for (uint8_t channel = 0; channel < 16; ++channel) {
+                for (uint8_t key = 0; key < 128; ++key) {
+                    parser->note_off(channel, key, parser->end);
+                }
+            }
+
+            // A format 0 file keeps every channel in its single track, they become tracks of their own
+            MidiFile::Track* merged = nullptr;
+            for (uint8_t channel = 0; channel < 16; ++channel) {
+                auto& notes = parser->notes[channel];
+                if (notes.empty()) {
+                    continue;
+                }
+                if (format == 0 || merged == nullptr) {
+                    merged = &file.tracks.emplace_back(MidiFile::Track{parser->name, channel, std::move(notes)});
+                } else {
+                    const auto middle = static_cast<std::ptrdiff_t>(merged->notes.size());
+                    merged->notes.insert(merged->notes.end(), notes.begin(), notes.end());
+                    std::inplace_merge(merged->notes.begin(), merged->notes.begin() + middle, merged->notes.end(), [](const Sequencing::Note& a, const Sequencing::Note& b) {
+                        return a.tick < b.tick;
+                    });
+                }
+            }
+        }
+        std::stable_sort(file.tempo.begin(), file.tempo.end(), [](const auto& a, const auto& b) { return a.tick < b.tick; });
+        return file;
+    }
+
+    std::optional<MidiFile> load_smf(const std::string& path, std::string* error) {
+        const MappedFile mapped(path);
+        if (!mapped.is_open()) {
+            fail(error, "Could not open " + path);
+            return std::nullopt;
+        }
+        return parse_smf(mapped.bytes(), error);
+    }
+
+    std::vector<uint8_t> write_smf(const MidiFile& file) {
+        size_t note_count = 0;
+        for (const auto& track : file.tracks) {
+            note_count += track.notes.size();
+        }
+        std::vector<uint8_t> out;
+        out.reserve(64 + file.tempo.size() * 8 + file.tracks.size() * 64 + note_count * 8);
+
+        out.insert(out.end(), {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1});
+        put_big_endian(out, static_cast<uint32_t>(file.tracks.size() + 1), 2);
+        put_big_endian(out, Sequencing::TempoMap::ticks_per_quarter, 2);
+
+        // Tempo track
+        size_t start = begin_track(out);
+        uint64_t previous = 0;
+        for (const auto& change : file.tempo) {
+            put_vlq(out, static_cast<uint32_t>(bridge_gap(out, change.tick - previous)));
+            previous = change.tick;
+            out.insert(out.end(), {0xFF, 0x51, 0x03});
+            put_big_endian(out, static_cast<uint32_t>(std::lround(60'000'000.0 / change.bpm)), 3);
+        }
+        end_track(out, start);
+
+        // The notes are sorted by start already, their ends wait in a min heap that only holds the notes
+        // sounding at once
+        struct Off {
+            uint64_t tick;
+            uint8_t pitch;
+        };
+        const auto later = [](const Off& a, const Off& b) { return a.tick > b.tick; };
+        std::vector<Off> offs;
+        for (const auto& track : file.tracks) {
+            offs.clear();
+
+            start = begin_track(out);
+            if (!track.name.empty()) {
+                out.insert(out.end(), {0x00, 0xFF, 0x03});
+                put_vlq(out, static_cast<uint32_t>(track.name.size()));
+                out.insert(out.end(), track.name.begin(), track.name.end());
+            }
+            // NoteOffs are written as NoteOns with velocity 0, so the whole track runs on one running status
+            // Written through a pointer into space for the worst case, an event is at most a four byte delta
+            // and two data bytes
+            const size_t written = out.size();
+            out.resize(written + 1 + track.notes.size() * 2 * 6);
+            uint8_t* cursor = out.data() + written;
+            const uint8_t status = 0x90 | (track.channel & 0x0F);
+            previous = 0;
+            bool first = true;
+            const auto put_event = [&](uint64_t tick, uint8_t pitch, uint8_t velocity) {
+                uint64_t gap = tick - previous;
+                previous = tick;
+                if (gap > max_delta) {
+                    // Rare, the bridge goes through the vector and the space left for the events after it
+                    // is added back behind it, with a byte for the status it restarts
+                    const size_t offset = static_cast<size_t>(cursor - out.data());
+                    const size_t slack = out.size() - offset;
+                    out.resize(offset);
+                    gap = bridge_gap(out, gap);
+                    out.resize(out.size() + slack + 1);
+                    cursor = out.data() + out.size() - slack - 1;
+                    first = true;
+                }
+                const auto delta = static_cast<uint32_t>(gap);
+                for (int shift = 21; shift > 0; shift -= 7) {
+                    if (delta >> shift) {
+                        *cursor++ = static_cast<uint8_t>(((delta >> shift) & 0x7F) | 0x80);
+                    }
+                }
+                *cursor++ = delta & 0x7F;
+                if (first) {
+                    *cursor++ = status;
+                    first = false;
+                }
+                *cursor++ = pitch & 0x7F;
+                *cursor++ = velocity;
+            };
+
+            // NoteOffs first on the same tick, so back to back notes do not cut each other
+            const auto end_notes = [&](uint64_t until) {
+                while (!offs.empty() && offs.front().tick <= until) {
+                    std::pop_heap(offs.begin(), offs.end(), later);
+                    put_event(offs.back().tick, offs.back().pitch, 0);
+                    offs.pop_back();
+                }
+            };
+            for (const auto& note : track.notes) {
+                end_notes(note.tick);
+                put_event(note.tick, note.pitch, static_cast<uint8_t>(std::clamp<int>(note.velocity, 1, 127)));
+                offs.push_back({note.end(), note.pitch});
+                std::push_heap(offs.begin(), offs.end(), later);
+            }
+            end_notes(UINT64_MAX);
+            out.resize(static_cast<size_t>(cursor - out.data()));
+            end_track(out, start);
+        }
+        return out;
+    }
+
+    bool save_smf(const std::string& path, const MidiFile& file, std::string* error) {
+        const auto bytes = write_smf(file);
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            fail(error, "Could not create " + path);
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            fail(error, "Could not write " + path);
+            return false;
+        }
+        return true;
+    }
+
+    Sequencing::Pattern to_pattern(const MidiFile& file, const std::vector<AudioGenerator*>& generators, int id) {
+        Sequencing::Pattern pattern;
+        pattern.id = id;
+        if (generators.empty()) {
+            return pattern;
+        }
+        pattern.note_sequences.reserve(file.tracks.size());
+        for (size_t i = 0; i < file.tracks.size(); ++i) {
+            auto& sequence = pattern.note_sequences.emplace_back();
+            sequence.generator = generators[i % generators.size()];
+            for (const auto& note : file.tracks[i].notes) {
+                sequence.add_note(note);
+            }
+        }
+        if (!file.tracks.empty() && !file.tracks.front().name.empty()) {
+            pattern.name = file.tracks.front().name;
+        }
+        return pattern;
+    }
+
+    MidiFile from_pattern(const Sequencing::Pattern& pattern, const Sequencing::TempoMap& tempo) {
+        MidiFile file;
+        for (const auto& change : tempo.get_changes()) {
+            file.tempo.push_back(change);
+        }
+        for (const auto& sequence : pattern.note_sequences) {
+            MidiFile::Track track;
+            track.name = sequence.generator ? sequence.generator->name : pattern.name;
+            track.channel = static_cast<uint8_t>(file.tracks.size() % 16);
+            track.notes.reserve(sequence.notes.size());
+            for (const auto& note : sequence.notes) {
+                if (note.length > 0 && !note.is_muted()) {
+                    track.notes.push_back(note);
+                }
+            }
+            file.tracks.push_back(std::move(track));
+        }
+        return file;
+    }
+} // midi
+} // audio
@@ -0,0 +1,47 @@
+#ifndef MIDIFILE_H
+#define MIDIFILE_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "audio/AudioGenerator.h"
+#include "audio/Sequencing/Note.h"
+#include "audio/Sequencing/Pattern.h"
+#include "audio/Sequencing/TempoMap.h"
+
+namespace audio {
+namespace midi {
+
+// The notes and tempo of a Standard MIDI File, ticks already rescaled to TempoMap::ticks_per_quarter.
+struct MidiFile {
+    struct Track {
+        std::string name;
+        uint8_t channel = 0;
+        std::vector<Sequencing::Note> notes; // Sorted by tick
+    };
+
+    std::vector<Track> tracks; // One per file track with notes, a format 0 file is split by channel
+    std::vector<Sequencing::TempoMap::Change> tempo; // Sorted by tick, empty when the file sets none (120 BPM)
+};
+
+// Parsers return std::nullopt and fill error (when given) for malformed input. SMPTE time division is not supported.
+std::optional<MidiFile> parse_smf(std::span<const uint8_t> data, std::string* error = nullptr);
+// Parses straight out of a memory mapping of the file, without reading it into memory first.
+std::optional<MidiFile> load_smf(const std::string& path, std::string* error = nullptr);
+
+// Format 1 with a tempo track first, then one track per MidiFile track on its channel.
+std::vector<uint8_t> write_smf(const MidiFile& file);
+bool save_smf(const std::string& path, const MidiFile& file, std::string* error = nullptr);
+
+// Track i becomes a note sequence playing generators[i % size], none when generators is empty.
+Sequencing::Pattern to_pattern(const MidiFile& file, const std::vector<AudioGenerator*>& generators, int id);
+// One track per note sequence, muted and zero length notes are left out.
+MidiFile from_pattern(const Sequencing::Pattern& pattern, const Sequencing::TempoMap& tempo);
+
+} // midi
+} // audio
+
+#endif //MIDIFILE_H
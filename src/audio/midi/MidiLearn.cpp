@@ -0,0 +1,68 @@
+#include "MidiLearn.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+namespace midi {
+    float CcMapping::map(uint16_t value) const {
+        const float position = std::pow(static_cast<float>(std::min<uint16_t>(value, 127)) / 127.0f, curve);
+        return min + (max - min) * position;
+    }
+
+    MidiLearn::MidiLearn() {
+        publish({});
+    }
+
+    void MidiLearn::handle(const MidiMessage& message) {
+        if (message.type != MessageType::ControlChange) {
+            return;
+        }
+        last_controller.store(moved | message.device << 16 | message.channel << 8 | message.key, std::memory_order_relaxed);
+
+        for (const auto& mapping : *current.load(std::memory_order_acquire)) {
+            if (mapping.controller == message.key && mapping.channel == message.channel && mapping.device == message.device) {
+                mapping.generator->parameters.queue(mapping.parameter, mapping.map(message.value), message.time);
+            }
+        }
+    }
+
+    void MidiLearn::assign(const CcMapping& mapping) {
+        Table table = *tables.back();
+        auto it = std::find_if(table.begin(), table.end(), [&](const CcMapping& existing) {
+            return existing.device == mapping.device && existing.channel == mapping.channel && existing.controller == mapping.controller
+                   && existing.generator == mapping.generator && existing.parameter == mapping.parameter;
+        });
+        if (it != table.end()) {
+            *it = mapping;
+        } else {
+            table.push_back(mapping);
+        }
+        publish(std::move(table));
+    }
+
+    void MidiLearn::remove(AudioGenerator* generator, uint16_t parameter) {
+        Table table = *tables.back();
+        std::erase_if(table, [&](const CcMapping& mapping) {
+            return mapping.generator == generator && mapping.parameter == parameter;
+        });
+        publish(std::move(table));
+    }
+
+    bool MidiLearn::take_last_controller(uint8_t& device, uint8_t& channel, uint8_t& controller) {
+        const uint32_t last = last_controller.exchange(0, std::memory_order_relaxed);
+        if ((last & moved) == 0) {
+            return false;
+        }
+        device = static_cast<uint8_t>(last >> 16);
+        channel = static_cast<uint8_t>(last >> 8);
+        controller = static_cast<uint8_t>(last);
+        return true;
+    }
+
+    void MidiLearn::publish(Table table) {
+        tables.push_back(std::make_unique<const Table>(std::move(table)));
+        current.store(tables.back().get(), std::memory_order_release);
+    }
+} // midi
+} // audio
@@ -0,0 +1,66 @@
+#ifndef MIDILEARN_H
+#define MIDILEARN_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "MidiMessage.h"
+#include "audio/AudioGenerator.h"
+
+namespace audio {
+namespace midi {
+
+// A controller driving one generator parameter, value = min + (max - min) * (cc / 127) ^ curve.
+// min above max turns the controller around.
+struct CcMapping {
+    uint8_t device;
+    uint8_t channel;
+    uint8_t controller;
+    AudioGenerator* generator;
+    uint16_t parameter; // Into generator->parameters
+    float min;
+    float max;
+    float curve = 1.0f; // Below 1 rises fast at the start, above 1 slowly
+
+    [[nodiscard]] float map(uint16_t value) const;
+};
+
+// Controller to parameter mappings. The MIDI threads read the current table lock free and only queue values
+// into the generators' parameter stores, the audio thread applies them. Edited from the UI thread only.
+class MidiLearn {
+public:
+    MidiLearn();
+
+    MidiLearn(const MidiLearn&) = delete;
+    MidiLearn& operator=(const MidiLearn&) = delete;
+
+    // MIDI input threads: queues the mapped value for every parameter the controller drives.
+    void handle(const MidiMessage& message);
+
+    // Replaces the mapping of the same controller to the same parameter, or adds it.
+    void assign(const CcMapping& mapping);
+    void remove(AudioGenerator* generator, uint16_t parameter);
+    [[nodiscard]] const std::vector<CcMapping>& get_mappings() const { return *tables.back(); }
+
+    // The last controller moved on any input since the previous call, false when none was. For learning.
+    bool take_last_controller(uint8_t& device, uint8_t& channel, uint8_t& controller);
+
+private:
+    using Table = std::vector<CcMapping>;
+
+    std::atomic<const Table*> current;
+    // Every table ever published, a MIDI thread may still be reading an old one. A few bytes per edit.
+    std::vector<std::unique_ptr<const Table>> tables;
+    std::atomic<uint32_t> last_controller = 0; // moved | device << 16 | channel << 8 | controller
+
+    static constexpr uint32_t moved = 1u << 31;
+
+    void publish(Table table);
+};
+
+} // midi
+} // audio
+
+#endif //MIDILEARN_H
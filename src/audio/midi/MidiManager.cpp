@@ -5,65 +5,196 @@
 
 namespace audio {
 namespace midi {
+    // Runs on the driver's thread for every incoming message, no console output or allocation in here
     void midiInputCallback(double time_stamp, std::vector<unsigned char> * message, void * user_data) {
-        MidiManager * manager = static_cast<MidiManager *>(user_data);
-        if (manager == nullptr || message->size() < 3) {
-            return; // Invalid message
+        const double arrival = ClockMapper::host_now();
+        auto * device = static_cast<MidiDevice *>(user_data);
+        if (device == nullptr || message == nullptr) {
+            return;
         }
-        int status = (*message)[0];
-        int note = (*message)[1];
-        int velocity = (*message)[2];
-        if (status < 0x80 || status > 0xEF) {
-            return; // Invalid MIDI status byte
+
+        MidiMessage decoded{};
+        if (!decode(message->data(), message->size(), device->index, decoded)) {
+            return; // System or malformed message
         }
 
-        // If it is a Note On message
-        if (status >= 0x90 && status <= 0x9F) {
-            for (const auto &callback : manager->note_callbacks) {
-                callback(note, velocity);
-            }
-        }else {
-            // Anything else goes to general callbacks
-            for (const auto &callback : manager->general_callbacks) {
-                callback(status, note, velocity);
-            }
+        // The driver's timestamp says when the message was received, which is more precise than when this runs
+        const double host = device->clock.host_time(time_stamp, arrival);
+        uint64_t sample = 0;
+        if (device->manager->clock.sample_at(host, sample)) {
+            decoded.time = sample;
         }
+        for (const auto &callback : device->manager->message_callbacks) {
+            callback(decoded);
+        }
+    }
+
+MidiManager::MidiManager() = default;
+
+MidiManager::~MidiManager() {
+    watcher.request_stop();
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+    for (auto& device : input_devices) {
+        close(*device);
+    }
+}
+
+void MidiManager::start() {
+    if (!watcher.joinable()) {
+        watcher = std::jthread([this](std::stop_token stop) { watch(stop); });
     }
+}
 
-MidiManager::MidiManager() {
-    enabled = false;
+void MidiManager::rescan() {
+    {
+        std::lock_guard lock(devices_mutex);
+        scan_pending = true;
+    }
+    scan_requested.notify_one();
+}
 
-    midiin = new RtMidiIn();
+std::vector<MidiManager::DeviceInfo> MidiManager::GetDevices() {
+    std::lock_guard lock(devices_mutex);
+    std::vector<DeviceInfo> devices;
+    devices.reserve(input_devices.size());
+    for (const auto& device : input_devices) {
+        devices.push_back({device->name, device->connected, device->midiin != nullptr, device->wanted});
+    }
+    return devices;
+}
 
-    unsigned int nPorts = midiin->getPortCount();
-    if (nPorts == 0) {
-        std::cerr << "No MIDI input ports available!" << std::endl;
+void MidiManager::SetDeviceWanted(size_t index, bool wanted) {
+    {
+        std::lock_guard lock(devices_mutex);
+        if (index >= input_devices.size()) {
+            return;
+        }
+        input_devices[index]->wanted = wanted;
+    }
+    rescan();
+}
+
+void MidiManager::watch(std::stop_token stop) {
+    // Enumerating can take a while with some drivers, which is why none of this runs during startup
+    std::unique_ptr<RtMidiIn> probe;
+    try {
+        probe = std::make_unique<RtMidiIn>();
+    } catch (const RtMidiError& error) {
+        std::cerr << "MIDI input unavailable: " << error.getMessage() << std::endl;
         return;
     }
-    for (unsigned int i = 0; i < nPorts; ++i) {
-        std::string portName = midiin->getPortName(i);
-        if (portName.empty()) {
-            continue;
+
+    while (!stop.stop_requested()) {
+        try {
+            scan(*probe);
+        } catch (const RtMidiError& error) {
+            std::cerr << "MIDI scan failed: " << error.getMessage() << std::endl;
         }
 
-        MidiDevice device{};
-        device.port = i;
-        device.name = portName.c_str();
-        device.midiin = new RtMidiIn();
-        device.midiin->openPort(i);
-        device.midiin->setCallback(midiInputCallback, this);
-        input_devices.push_back(device);
+        std::unique_lock lock(devices_mutex);
+        scan_requested.wait_for(lock, stop, scan_interval, [this] { return scan_pending; });
+        scan_pending = false;
+    }
+}
 
-        std::cout << "Found MIDI input device: " << portName << " (Port " << i << ")" << std::endl;
+void MidiManager::scan(RtMidiIn& probe) {
+    // Port names are read without the lock, the UI keeps drawing while a slow driver answers
+    std::vector<std::string> names;
+    const unsigned int port_count = probe.getPortCount();
+    names.reserve(port_count);
+    for (unsigned int i = 0; i < port_count; ++i) {
+        names.push_back(probe.getPortName(i));
     }
 
-    // We will not handle output devices for now
-    if (input_devices.empty()) {
-        enabled = false;
-        return;
+    std::lock_guard lock(devices_mutex);
+    std::vector<bool> seen(input_devices.size(), false);
+    for (unsigned int i = 0; i < port_count; ++i) {
+        if (names[i].empty()) {
+            continue;
+        }
+        // Devices are told apart by name, two of the same kind in the order their ports are listed
+        MidiDevice* device = nullptr;
+        for (size_t d = 0; d < input_devices.size(); ++d) {
+            if (!seen[d] && input_devices[d]->name == names[i]) {
+                device = input_devices[d].get();
+                seen[d] = true;
+                break;
+            }
+        }
+        if (device == nullptr && input_devices.size() == max_devices) {
+            if (!device_limit_reported) {
+                std::cerr << "Too many MIDI input devices, ignoring " << names[i] << " and any after it" << std::endl;
+                device_limit_reported = true;
+            }
+            continue;
+        }
+        if (device == nullptr) {
+            auto added = std::make_unique<MidiDevice>();
+            added->name = names[i];
+            added->manager = this;
+            added->index = static_cast<uint8_t>(input_devices.size());
+            device = added.get();
+            input_devices.push_back(std::move(added));
+            seen.push_back(true);
+            std::cout << "Found MIDI input device: " << device->name << " (Port " << i << ")" << std::endl;
+        } else if (!device->connected) {
+            std::cout << "MIDI input device reconnected: " << device->name << std::endl;
+        }
+        device->port = static_cast<int>(i);
+        device->connected = true;
     }
 
-    enabled = true;
+    for (size_t d = 0; d < input_devices.size(); ++d) {
+        MidiDevice& device = *input_devices[d];
+        if (!seen[d] && device.connected) {
+            std::cout << "MIDI input device disconnected: " << device.name << std::endl;
+            device.connected = false;
+            device.port = -1;
+        }
+        // Ports are opened while wanted, and closed again when unplugged or switched off
+        const bool should_open = device.connected && device.wanted;
+        if (should_open && device.midiin != nullptr && (device.port != device.open_port || !device.midiin->isPortOpen())) {
+            // Unplugged and back within one scan, the handle still points at the port that went away
+            std::cout << "MIDI input device replugged: " << device.name << std::endl;
+            close(device);
+        }
+        if (should_open && device.midiin == nullptr) {
+            try {
+                open(device);
+            } catch (const RtMidiError& error) {
+                // Most likely held exclusively by another program, left closed until it is switched on again
+                std::cerr << "Could not open MIDI input " << device.name << ": " << error.getMessage() << std::endl;
+                device.wanted = false;
+            }
+        } else if (!should_open && device.midiin != nullptr) {
+            close(device);
+        }
+    }
+}
+
+void MidiManager::open(MidiDevice& device) {
+    auto midiin = std::make_unique<RtMidiIn>();
+    midiin->openPort(static_cast<unsigned int>(device.port), device.name);
+    device.clock = DeviceClock{}; // The driver's deltas start over with the port
+    midiin->setCallback(midiInputCallback, &device);
+    device.midiin = midiin.release();
+    device.open_port = device.port;
+    open_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MidiManager::close(MidiDevice& device) {
+    if (device.midiin == nullptr) {
+        return;
+    }
+    // Closing waits for the port's input thread, no callback runs for the device after this
+    device.midiin->cancelCallback();
+    device.midiin->closePort();
+    delete device.midiin;
+    device.midiin = nullptr;
+    device.open_port = -1;
+    open_count.fetch_sub(1, std::memory_order_relaxed);
 }
 } // midi
-} // audio
\ No newline at end of file
+} // audio
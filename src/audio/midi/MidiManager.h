@@ -1,33 +1,97 @@
 #ifndef MIDIMANAGER_H
 #define MIDIMANAGER_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 #include <functional>
 
 #include <RtMidi.h>
 
+#include "ClockMapper.h"
+#include "MidiLearn.h"
+#include "MidiMessage.h"
+#include "MidiRouting.h"
+
 namespace audio {
 namespace midi {
 
+class MidiManager;
+
+// One input port seen since startup. Kept when it is unplugged, so plugging it back in keeps its index and
+// with it its routes and controller mappings. Indices are never reused, see MidiManager::max_devices.
 struct MidiDevice {
-    int port;
-    const char *name;
-    RtMidiIn *midiin = nullptr;
+    int port = -1; // Current port number, ports shift as other devices come and go
+    std::string name;
+    RtMidiIn *midiin = nullptr; // Only while open
+    int open_port = -1; // Port number midiin was opened on
+    MidiManager *manager = nullptr; // Handed to the input callback together with the device index
+    uint8_t index = 0;
+    DeviceClock clock;
+    bool connected = false;
+    bool wanted = true; // Opened whenever it is connected, unless switched off from the UI
 };
 
 class MidiManager {
 public:
+    // What the UI gets to see of a device
+    struct DeviceInfo {
+        std::string name;
+        bool connected;
+        bool open;
+        bool wanted;
+    };
+
+    static constexpr auto scan_interval = std::chrono::seconds(1); // Hotplug polling
+    // Devices seen since startup, one per routing table row. Ports with new names past it are left alone.
+    static constexpr size_t max_devices = MidiRouting::max_devices;
+
     explicit MidiManager();
+    ~MidiManager();
+
+    MidiManager(const MidiManager&) = delete;
+    MidiManager& operator=(const MidiManager&) = delete;
 
-    std::vector<std::function<void(int, int)>> note_callbacks;
-    std::vector<std::function<void(int, int, int)>> general_callbacks;
+    // Called on the driver's input threads with every decoded channel message, keep them short and never block.
+    // Register before start().
+    std::vector<std::function<void(const MidiMessage&)>> message_callbacks;
 
-    [[nodiscard]] bool IsEnabled () const { return enabled; }
+    MidiRouting routing;
+    MidiLearn learn; // Controllers mapped to generator parameters
+    ClockMapper clock; // Fed by the audio callback, places incoming messages on the output sample clock
+
+    // Starts enumerating and watching ports on a background thread, which also opens them.
+    void start();
+    // Scans now instead of at the next interval.
+    void rescan();
+
+    // True while at least one port is open.
+    [[nodiscard]] bool IsEnabled () const { return open_count.load(std::memory_order_relaxed) > 0; }
+    // Indexed like MidiMessage::device.
+    [[nodiscard]] std::vector<DeviceInfo> GetDevices();
+    // Opens (or closes) the device's port from the next scan on, which this triggers.
+    void SetDeviceWanted(size_t index, bool wanted);
 
 private:
-    bool enabled = false;
-    RtMidiIn  *midiin;
-    std::vector<MidiDevice> input_devices;
+    std::atomic<int> open_count = 0;
+
+    std::mutex devices_mutex; // UI and the watcher thread, the input callbacks never take it
+    std::condition_variable_any scan_requested;
+    bool scan_pending = false;
+    bool device_limit_reported = false;
+    std::vector<std::unique_ptr<MidiDevice>> input_devices; // Boxed, the input callbacks keep pointers to them
+
+    std::jthread watcher;
+
+    void watch(std::stop_token stop);
+    void scan(RtMidiIn& probe);
+    void open(MidiDevice& device);
+    void close(MidiDevice& device);
 };
 
 } // midi
@@ -0,0 +1,47 @@
+#include "MidiMessage.h"
+
+namespace audio {
+namespace midi {
+    bool decode(const unsigned char* bytes, size_t size, uint8_t device, MidiMessage& out) {
+        if (size == 0 || bytes[0] < 0x80 || bytes[0] >= 0xF0) {
+            return false; // Running status is expanded by the driver, system messages are not handled
+        }
+        const uint8_t status = bytes[0] & 0xF0;
+        const uint8_t channel = bytes[0] & 0x0F;
+
+        // Program change and channel pressure carry one data byte, everything else two
+        const size_t length = status == 0xC0 || status == 0xD0 ? 2 : 3;
+        if (size < length || (bytes[1] & 0x80) || (length == 3 && (bytes[2] & 0x80))) {
+            return false;
+        }
+        const uint8_t first = bytes[1];
+        const uint8_t second = length == 3 ? bytes[2] : 0;
+
+        switch (status) {
+            case 0x80:
+                out = {MessageType::NoteOff, device, channel, first, second};
+                return true;
+            case 0x90:
+                out = {second == 0 ? MessageType::NoteOff : MessageType::NoteOn, device, channel, first, second};
+                return true;
+            case 0xA0:
+                out = {MessageType::PolyPressure, device, channel, first, second};
+                return true;
+            case 0xB0:
+                out = {MessageType::ControlChange, device, channel, first, second};
+                return true;
+            case 0xC0:
+                out = {MessageType::ProgramChange, device, channel, 0, first};
+                return true;
+            case 0xD0:
+                out = {MessageType::ChannelPressure, device, channel, 0, first};
+                return true;
+            case 0xE0:
+                out = {MessageType::PitchBend, device, channel, 0, static_cast<uint16_t>(first | (second << 7))};
+                return true;
+            default:
+                return false;
+        }
+    }
+} // midi
+} // audio
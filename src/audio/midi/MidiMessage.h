@@ -0,0 +1,43 @@
+#ifndef MIDIMESSAGE_H
+#define MIDIMESSAGE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace audio {
+namespace midi {
+
+    enum class MessageType : uint8_t {
+        NoteOff,
+        NoteOn,
+        PolyPressure, // Aftertouch per note
+        ControlChange,
+        ProgramChange,
+        ChannelPressure, // Aftertouch for the whole channel
+        PitchBend
+    };
+
+    // One decoded channel message, small enough to pass around by value on the MIDI threads.
+    struct MidiMessage {
+        MessageType type;
+        uint8_t device; // Index of the input port it came from
+        uint8_t channel; // 0-15
+        uint8_t key; // Note or controller number, 0 when the message has none
+        uint16_t value; // Velocity, controller value, pressure or program (0-127), pitch bend (0-16383, 8192 centred)
+        uint64_t time = 0; // Output sample it should play at, 0 to play it as soon as possible
+
+        [[nodiscard]] bool is_note() const { return type == MessageType::NoteOn || type == MessageType::NoteOff; }
+    };
+
+    static_assert(sizeof(MidiMessage) == 16);
+
+    inline constexpr uint16_t pitch_bend_centre = 8192;
+
+    // Decodes one complete message as delivered by the MIDI driver. A NoteOn with velocity 0 becomes a NoteOff.
+    // System and malformed messages return false.
+    bool decode(const unsigned char* bytes, size_t size, uint8_t device, MidiMessage& out);
+
+} // midi
+} // audio
+
+#endif //MIDIMESSAGE_H
@@ -0,0 +1,55 @@
+#ifndef MIDIROUTING_H
+#define MIDIROUTING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace audio {
+namespace midi {
+
+// Which generator every (device, channel) plays, so several keyboards can drive several generators at once.
+// Written from the UI, read lock free on the MIDI input threads.
+class MidiRouting {
+public:
+    static constexpr size_t max_devices = 16;
+    static constexpr int follow_selection = -1; // Plays the generator selected in the UI, the default
+    static constexpr int ignored = -2;
+
+    MidiRouting() {
+        for (auto& device : routes) {
+            for (auto& route : device) {
+                route.store(follow_selection, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Generator index, or follow_selection / ignored. Devices past max_devices always follow the selection.
+    void set(uint8_t device, uint8_t channel, int generator) {
+        if (device < max_devices && channel < 16) {
+            routes[device][channel].store(generator, std::memory_order_relaxed);
+        }
+    }
+
+    void set_device(uint8_t device, int generator) {
+        for (uint8_t channel = 0; channel < 16; ++channel) {
+            set(device, channel, generator);
+        }
+    }
+
+    [[nodiscard]] int get(uint8_t device, uint8_t channel) const {
+        if (device >= max_devices || channel >= 16) {
+            return follow_selection;
+        }
+        return routes[device][channel].load(std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::array<std::atomic<int>, 16>, max_devices> routes;
+};
+
+} // midi
+} // audio
+
+#endif //MIDIROUTING_H
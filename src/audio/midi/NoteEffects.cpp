@@ -0,0 +1,329 @@
+#include "NoteEffects.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+namespace midi {
+    using Sequencing::EventType;
+    using Sequencing::NoteEvent;
+
+    namespace {
+        bool before(const NoteEvent& a, const NoteEvent& b) {
+            if (a.time != b.time) {
+                return a.time < b.time;
+            }
+            return a.type < b.type;
+        }
+
+        NoteEvent note_on(uint64_t time, int note, uint8_t velocity) {
+            return {time, 0, EventType::NoteOn, static_cast<uint8_t>(note), velocity};
+        }
+
+        NoteEvent note_off(uint64_t time, int note) {
+            return {time, 0, EventType::NoteOff, static_cast<uint8_t>(note), 0};
+        }
+
+        uint64_t step_length(float steps_per_quarter, double samples_per_quarter) {
+            return std::max<uint64_t>(static_cast<uint64_t>(samples_per_quarter / std::max(steps_per_quarter, 0.01f)), 1);
+        }
+
+        uint64_t gate_length(float gate, uint64_t step) {
+            return std::clamp<uint64_t>(static_cast<uint64_t>(static_cast<double>(step) * gate), 1, step);
+        }
+    }
+
+    void EventBuffer::sort() {
+        for (size_t i = 1; i < count; ++i) {
+            const NoteEvent event = events[i];
+            size_t j = i;
+            for (; j > 0 && before(event, events[j - 1]); --j) {
+                events[j] = events[j - 1];
+            }
+            events[j] = event;
+        }
+    }
+
+    void Transpose::process(const EventBuffer& in, EventBuffer& out, const BlockInfo&) {
+        const int shift = semitones.load(std::memory_order_relaxed);
+        for (const auto& event : in) {
+            if (event.type == EventType::NoteOn) {
+                const int note = event.note + shift;
+                if (note < 0 || note > 127) {
+                    continue;
+                }
+                sounding[event.note] = static_cast<int16_t>(note);
+                out.push(note_on(event.time, note, event.velocity));
+            } else if (sounding[event.note] >= 0) {
+                out.push(note_off(event.time, sounding[event.note]));
+                sounding[event.note] = -1;
+            } else {
+                out.push(event); // Started before the transposer was on
+            }
+        }
+    }
+
+    void Transpose::release(EventBuffer& out, uint64_t time) {
+        for (auto& note : sounding) {
+            if (note >= 0) {
+                out.push(note_off(time, note));
+                note = -1;
+            }
+        }
+    }
+
+    void Chord::process(const EventBuffer& in, EventBuffer& out, const BlockInfo&) {
+        const size_t count = std::min<size_t>(interval_count.load(std::memory_order_relaxed), max_intervals);
+        std::array<int8_t, max_intervals> added{};
+        for (size_t i = 0; i < count; ++i) {
+            added[i] = intervals[i].load(std::memory_order_relaxed);
+        }
+
+        for (const auto& event : in) {
+            auto& notes = sounding[event.note];
+            if (event.type == EventType::NoteOn) {
+                notes.reset();
+                notes.set(event.note);
+                for (size_t i = 0; i < count; ++i) {
+                    const int note = event.note + added[i];
+                    if (note >= 0 && note <= 127) {
+                        notes.set(static_cast<size_t>(note));
+                    }
+                }
+                for (size_t note = 0; note < 128; ++note) {
+                    if (notes.test(note)) {
+                        out.push(note_on(event.time, static_cast<int>(note), event.velocity));
+                    }
+                }
+            } else if (notes.any()) {
+                for (size_t note = 0; note < 128; ++note) {
+                    if (notes.test(note)) {
+                        out.push(note_off(event.time, static_cast<int>(note)));
+                    }
+                }
+                notes.reset();
+            } else {
+                out.push(event);
+            }
+        }
+    }
+
+    void Chord::release(EventBuffer& out, uint64_t time) {
+        for (auto& notes : sounding) {
+            for (size_t note = 0; notes.any() && note < 128; ++note) {
+                if (notes.test(note)) {
+                    out.push(note_off(time, static_cast<int>(note)));
+                }
+            }
+            notes.reset();
+        }
+    }
+
+    int Arpeggiator::note_at(size_t step, Mode order_mode, int octave_count, uint8_t& velocity) const {
+        // Held notes, lowest first (or in the order they were pressed)
+        std::array<uint8_t, 128> notes{};
+        size_t count = 0;
+        if (order_mode == Mode::AsPlayed) {
+            std::copy_n(order.begin(), held, notes.begin());
+            count = held;
+        } else {
+            for (size_t note = 0; note < 128; ++note) {
+                if (velocities[note] > 0) {
+                    notes[count++] = static_cast<uint8_t>(note);
+                }
+            }
+        }
+        if (count == 0) {
+            return -1;
+        }
+
+        const size_t span = count * static_cast<size_t>(std::clamp(octave_count, 1, 4));
+        size_t index = step % span;
+        if (order_mode == Mode::Down) {
+            index = span - 1 - index;
+        } else if (order_mode == Mode::UpDown && span > 1) {
+            // Up then back down, without repeating the top and bottom notes
+            index = step % (2 * span - 2);
+            if (index >= span) {
+                index = 2 * span - 2 - index;
+            }
+        }
+        const uint8_t base = notes[index % count];
+        velocity = velocities[base];
+        return std::min<int>(base + 12 * static_cast<int>(index / count), 127);
+    }
+
+    void Arpeggiator::end_playing(EventBuffer& out, uint64_t time) {
+        if (playing >= 0) {
+            out.push(note_off(time, playing));
+            playing = -1;
+        }
+    }
+
+    void Arpeggiator::process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) {
+        const uint64_t step = step_length(steps_per_quarter.load(std::memory_order_relaxed), block.samples_per_quarter);
+        const uint64_t held_for = gate_length(gate.load(std::memory_order_relaxed), step);
+        const Mode order_mode = mode.load(std::memory_order_relaxed);
+        const int octave_count = octaves.load(std::memory_order_relaxed);
+        size_t next = 0;
+
+        // Gate ends, input and steps in time order, in that order on the same sample
+        for (;;) {
+            const uint64_t input_time = next < in.size() ? in[next].time : UINT64_MAX;
+            const uint64_t step_time = held > 0 ? next_step : UINT64_MAX;
+            const uint64_t off_time = playing >= 0 ? playing_off : UINT64_MAX;
+            const uint64_t time = std::min({input_time, step_time, off_time});
+            if (time >= block.end()) {
+                break;
+            }
+
+            if (off_time == time) {
+                end_playing(out, time);
+            } else if (input_time == time) {
+                const auto& event = in[next++];
+                if (event.type == EventType::NoteOn && velocities[event.note] == 0) {
+                    if (held == 0) {
+                        // The first key starts the pattern right away
+                        next_step = time;
+                        position = 0;
+                    }
+                    velocities[event.note] = std::max<uint8_t>(event.velocity, 1);
+                    order[held++] = event.note;
+                } else if (event.type == EventType::NoteOff && velocities[event.note] > 0) {
+                    velocities[event.note] = 0;
+                    auto end = std::remove(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(held), event.note);
+                    held = static_cast<size_t>(end - order.begin());
+                } else if (event.type == EventType::NoteOff) {
+                    out.push(event); // Started before the arpeggiator was on
+                }
+            } else {
+                end_playing(out, time);
+                uint8_t velocity = 0;
+                const int note = note_at(position++, order_mode, octave_count, velocity);
+                if (note >= 0) {
+                    out.push(note_on(time, note, velocity));
+                    playing = note;
+                    playing_off = time + held_for;
+                }
+                next_step = time + step;
+            }
+        }
+    }
+
+    void Arpeggiator::release(EventBuffer& out, uint64_t time) {
+        end_playing(out, time);
+        velocities.fill(0);
+        held = 0;
+    }
+
+    void NoteRepeat::process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) {
+        const uint64_t step = step_length(steps_per_quarter.load(std::memory_order_relaxed), block.samples_per_quarter);
+        const uint64_t held_for = gate_length(gate.load(std::memory_order_relaxed), step);
+        size_t next = 0;
+
+        for (;;) {
+            const bool any_held = std::any_of(velocities.begin(), velocities.end(), [](uint8_t v) { return v > 0; });
+            const uint64_t input_time = next < in.size() ? in[next].time : UINT64_MAX;
+            const uint64_t step_time = any_held ? next_step : UINT64_MAX;
+            const uint64_t off_time = on.any() ? gate_end : UINT64_MAX;
+            const uint64_t time = std::min({input_time, step_time, off_time});
+            if (time >= block.end()) {
+                break;
+            }
+
+            if (off_time == time) {
+                for (size_t note = 0; note < 128; ++note) {
+                    if (on.test(note)) {
+                        out.push(note_off(time, static_cast<int>(note)));
+                    }
+                }
+                on.reset();
+            } else if (input_time == time) {
+                const auto& event = in[next++];
+                if (event.type == EventType::NoteOn) {
+                    if (!any_held) {
+                        next_step = time; // The grid starts with the first key
+                    }
+                    velocities[event.note] = std::max<uint8_t>(event.velocity, 1);
+                } else if (velocities[event.note] == 0) {
+                    out.push(event); // Started before the repeat was on
+                } else {
+                    velocities[event.note] = 0;
+                    if (on.test(event.note)) {
+                        out.push(note_off(time, event.note));
+                        on.reset(event.note);
+                    }
+                }
+            } else {
+                for (size_t note = 0; note < 128; ++note) {
+                    if (velocities[note] == 0) {
+                        continue;
+                    }
+                    if (on.test(note)) {
+                        out.push(note_off(time, static_cast<int>(note)));
+                    }
+                    out.push(note_on(time, static_cast<int>(note), velocities[note]));
+                    on.set(note);
+                }
+                gate_end = time + held_for;
+                next_step = time + step;
+            }
+        }
+    }
+
+    void NoteRepeat::release(EventBuffer& out, uint64_t time) {
+        for (size_t note = 0; note < 128; ++note) {
+            if (on.test(note)) {
+                out.push(note_off(time, static_cast<int>(note)));
+            }
+        }
+        on.reset();
+        velocities.fill(0);
+    }
+
+    void VelocityCurve::process(const EventBuffer& in, EventBuffer& out, const BlockInfo&) {
+        const float exponent = std::max(curve.load(std::memory_order_relaxed), 0.01f);
+        const auto low = static_cast<float>(min.load(std::memory_order_relaxed));
+        const auto high = static_cast<float>(max.load(std::memory_order_relaxed));
+        for (auto event : in) {
+            if (event.type == EventType::NoteOn) {
+                const float shaped = std::pow(static_cast<float>(event.velocity) / 127.0f, exponent);
+                const float velocity = low + (high - low) * shaped;
+                event.velocity = static_cast<uint8_t>(std::clamp(std::lround(velocity), 1l, 127l));
+            }
+            out.push(event);
+        }
+    }
+
+    const EventBuffer& NoteEffectChain::process(const EventBuffer& in, uint64_t start, uint32_t frames) {
+        const BlockInfo block{start, frames, samples_per_quarter};
+        const EventBuffer* current = &in;
+        size_t next = 0;
+
+        for (size_t i = 0; i < stages.size(); ++i) {
+            NoteEffect* stage = stages[i];
+            const bool enabled = stage->enabled.load(std::memory_order_relaxed);
+            if (!enabled && !was_enabled[i]) {
+                continue;
+            }
+
+            EventBuffer& out = buffers[next];
+            out.clear();
+            if (enabled) {
+                stage->process(*current, out, block);
+            } else {
+                // Just switched off, end what it still holds and let the rest through untouched
+                stage->release(out, start);
+                for (const auto& event : *current) {
+                    out.push(event);
+                }
+                out.sort();
+            }
+            was_enabled[i] = enabled;
+            current = &out;
+            next ^= 1;
+        }
+        return *current;
+    }
+} // midi
+} // audio
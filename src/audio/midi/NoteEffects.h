@@ -0,0 +1,187 @@
+#ifndef NOTEEFFECTS_H
+#define NOTEEFFECTS_H
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio/AudioDefinitions.h"
+#include "audio/Sequencing/NoteEvent.h"
+
+namespace audio {
+namespace midi {
+
+// Fixed capacity list of one block's note events, so the audio thread never allocates. Events that do not
+// fit are dropped, NoteOns first: the last note_off_reserve slots only take NoteOffs, so a burst of NoteOns
+// (a chord effect multiplies them) can not push out the NoteOff of a note that is already sounding.
+class EventBuffer {
+public:
+    static constexpr size_t capacity = 512;
+    static constexpr size_t note_off_reserve = 128; // One per MIDI note
+
+    bool push(const Sequencing::NoteEvent& event) {
+        const size_t limit = event.type == Sequencing::EventType::NoteOn ? capacity - note_off_reserve : capacity;
+        if (count >= limit) {
+            return false;
+        }
+        events[count++] = event;
+        return true;
+    }
+
+    void clear() { count = 0; }
+
+    // By time, NoteOffs first on the same sample. Insertion sort, the input is nearly sorted already.
+    void sort();
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] const Sequencing::NoteEvent& operator[](size_t index) const { return events[index]; }
+    [[nodiscard]] const Sequencing::NoteEvent* begin() const { return events.data(); }
+    [[nodiscard]] const Sequencing::NoteEvent* end() const { return events.data() + count; }
+
+private:
+    std::array<Sequencing::NoteEvent, capacity> events{};
+    size_t count = 0;
+};
+
+// What an effect knows about the block it processes. Event times are output samples inside it.
+struct BlockInfo {
+    uint64_t start;
+    uint32_t frames;
+    double samples_per_quarter;
+
+    [[nodiscard]] uint64_t end() const { return start + frames; }
+};
+
+// One stage of a generator's note effect chain. Runs on the audio thread once per block. The settings are
+// atomics the UI stores while it plays, an effect loads them once at the start of each block.
+class NoteEffect {
+public:
+    std::atomic<bool> enabled{false};
+
+    virtual ~NoteEffect() = default;
+
+    // Turns the block's events into out, both sorted.
+    virtual void process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) = 0;
+    // Ends whatever the effect still holds at time and forgets it, called when it is switched off.
+    virtual void release(EventBuffer& out, uint64_t time) = 0;
+};
+
+class Transpose final : public NoteEffect {
+public:
+    std::atomic<int> semitones{0};
+
+    Transpose() { sounding.fill(-1); }
+
+    void process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) override;
+    void release(EventBuffer& out, uint64_t time) override;
+
+private:
+    // Output note per held input note (-1 when not held), so a NoteOff still matches after semitones changes
+    std::array<int16_t, 128> sounding{};
+};
+
+// Adds notes at fixed intervals above (or below) every incoming note.
+class Chord final : public NoteEffect {
+public:
+    static constexpr size_t max_intervals = 6;
+
+    std::array<std::atomic<int8_t>, max_intervals> intervals{4, 7}; // Semitones, a major triad by default
+    std::atomic<uint8_t> interval_count{2};
+
+    void process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) override;
+    void release(EventBuffer& out, uint64_t time) override;
+
+private:
+    std::array<std::bitset<128>, 128> sounding{}; // Output notes started per input note
+};
+
+// Plays the held notes one after another in steps, instead of all at once.
+class Arpeggiator final : public NoteEffect {
+public:
+    enum class Mode {
+        Up,
+        Down,
+        UpDown,
+        AsPlayed
+    };
+
+    std::atomic<Mode> mode{Mode::Up};
+    std::atomic<float> steps_per_quarter{4.0f}; // 16ths
+    std::atomic<float> gate{0.5f}; // Part of a step each note is held
+    std::atomic<int> octaves{1};
+
+    void process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) override;
+    void release(EventBuffer& out, uint64_t time) override;
+
+private:
+    std::array<uint8_t, 128> velocities{}; // Of the held notes, 0 when not held
+    std::array<uint8_t, 128> order{}; // Held notes in the order they were pressed
+    size_t held = 0;
+    size_t position = 0; // Step within the pattern
+    uint64_t next_step = 0; // Output sample
+    int playing = -1; // Note the arpeggiator has on, -1 when none
+    uint64_t playing_off = 0;
+
+    [[nodiscard]] int note_at(size_t step, Mode order_mode, int octave_count, uint8_t& velocity) const;
+    void end_playing(EventBuffer& out, uint64_t time);
+};
+
+// Retriggers every held note on a fixed grid for as long as it is held.
+class NoteRepeat final : public NoteEffect {
+public:
+    std::atomic<float> steps_per_quarter{4.0f};
+    std::atomic<float> gate{0.5f};
+
+    void process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) override;
+    void release(EventBuffer& out, uint64_t time) override;
+
+private:
+    std::array<uint8_t, 128> velocities{}; // Held notes, 0 when not held
+    std::bitset<128> on; // Currently sounding
+    uint64_t next_step = 0;
+    uint64_t gate_end = 0;
+};
+
+// Reshapes NoteOn velocities: out = min + (max - min) * (in / 127) ^ curve.
+class VelocityCurve final : public NoteEffect {
+public:
+    std::atomic<float> curve{1.0f}; // Below 1 louder, above 1 softer
+    std::atomic<uint8_t> min{1};
+    std::atomic<uint8_t> max{127};
+
+    void process(const EventBuffer& in, EventBuffer& out, const BlockInfo& block) override;
+    void release(EventBuffer&, uint64_t) override {}
+};
+
+// The effects of one generator in a fixed order, each switched on with its enabled flag. Live input and
+// sequenced events both pass through here once per block, so what comes out stays sample exact.
+class NoteEffectChain {
+public:
+    Transpose transpose;
+    Chord chord;
+    Arpeggiator arpeggiator;
+    NoteRepeat repeat;
+    VelocityCurve velocity;
+
+    double samples_per_quarter = SAMPLE_RATE / 2.0; // Set by the audio callback from the sequencer tempo
+
+    NoteEffectChain() = default;
+    NoteEffectChain(const NoteEffectChain&) = delete;
+    NoteEffectChain& operator=(const NoteEffectChain&) = delete;
+
+    // Audio thread: in must be sorted, the result stays valid until the next call.
+    const EventBuffer& process(const EventBuffer& in, uint64_t start, uint32_t frames);
+
+private:
+    std::array<NoteEffect*, 5> stages{&transpose, &chord, &arpeggiator, &repeat, &velocity};
+    std::array<bool, 5> was_enabled{};
+    EventBuffer buffers[2];
+};
+
+} // midi
+} // audio
+
+#endif //NOTEEFFECTS_H
@@ -1,7 +1,6 @@
 #ifndef NOTES_H
 #define NOTES_H
 #include <array>
-#include <cmath>
 
 namespace audio::piano {
     enum class Note {
@@ -44,27 +43,58 @@ namespace audio::piano {
         }
     }
 
-    constexpr float note_frequency(Note note, int octave) {
-        // A4 is 440 Hz
-        const float base_frequency = 440.0f;
-        const int semitones_from_A4 = static_cast<int>(note) - static_cast<int>(Note::A) + (octave - 4) * 12;
-        return base_frequency * std::pow(2.0f, semitones_from_A4 / 12.0f);
+    // Semitones above C within the octave, the enum itself starts at A.
+    constexpr int semitone_from_c(Note note) {
+        return (static_cast<int>(note) + 9) % 12;
     }
 
     constexpr int note_to_midi(Note note, int octave) {
         // MIDI note numbers start at C-1 (MIDI note 0)
         // A4 is MIDI note 69
-        return static_cast<int>(note) + (octave + 1) * 12 + 21; // 21 is the offset for MIDI note numbers
+        return semitone_from_c(note) + (octave + 1) * 12;
+    }
+
+    using FrequencyTable = std::array<float, 128>;
+
+    namespace detail {
+        // 2^(semitones / 12) in double, exact enough that every entry rounds to the nearest float.
+        constexpr double semitone_ratio(int semitones) {
+            constexpr double twelfth_root_of_two = 1.0594630943592952646;
+            double ratio = 1.0;
+            while (semitones >= 12) { ratio *= 2.0; semitones -= 12; }
+            while (semitones < 0) { ratio *= 0.5; semitones += 12; }
+            for (int i = 0; i < semitones; ++i) {
+                ratio *= twelfth_root_of_two;
+            }
+            return ratio;
+        }
+
+        constexpr FrequencyTable make_equal_temperament() {
+            FrequencyTable table{};
+            for (int i = 0; i < static_cast<int>(table.size()); ++i) {
+                // A4 (MIDI 69) is 440 Hz
+                table[i] = static_cast<float>(440.0 * semitone_ratio(i - 69));
+            }
+            return table;
+        }
     }
 
+    // 12-TET frequencies for every MIDI note, built at compile time.
+    constexpr FrequencyTable equal_temperament = detail::make_equal_temperament();
+
+    static_assert(note_to_midi(Note::A, 4) == 69);
+    static_assert(equal_temperament[69] == 440.0f);
+    static_assert(equal_temperament[57] == 220.0f);
+
     constexpr float midi_to_frequency(int midi_note) {
-        // Convert to note and octave, then pass to note_frequency (this later means we can use frequency mapping)
-        int octave = (midi_note / 12) - 1; // MIDI note 0 is C-1, so we subtract 1
-        int note_index = midi_note % 12; // Get the note index within the octave
-        if (note_index < 0 || note_index >= static_cast<int>(all_notes.size())) {
+        if (midi_note < 0 || midi_note >= static_cast<int>(equal_temperament.size())) {
             return 0.0f; // Invalid MIDI note
         }
-        return note_frequency(all_notes[note_index], octave);
+        return equal_temperament[midi_note];
+    }
+
+    constexpr float note_frequency(Note note, int octave) {
+        return midi_to_frequency(note_to_midi(note, octave));
     }
 }
 
@@ -0,0 +1,64 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <bit>
+#include <cstdint>
+
+// Counter based random numbers for the audio thread: every value is a pure function of (seed, counter),
+// so there is no shared state, no locking, identical output for offline renders and the loops vectorise.
+namespace audio::math::rng {
+
+    // Bijective 32 bit integer hash (lowbias32), good avalanche so consecutive counters give unrelated values.
+    constexpr uint32_t hash(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Derives an independent stream seed from any number of keys (generator seed, note, unison index, ...).
+    constexpr uint32_t combine(uint32_t seed, uint32_t key) {
+        return hash(seed ^ (key + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+    }
+
+    constexpr uint32_t at(uint32_t seed, uint32_t counter) {
+        return hash(counter + seed * 0x9e3779b9u);
+    }
+
+    // Uniform in [0, 1), from the top 23 bits.
+    constexpr float unit(uint32_t seed, uint32_t counter) {
+        return std::bit_cast<float>(0x3F800000u | (at(seed, counter) >> 9)) - 1.0f;
+    }
+
+    // Uniform in [-1, 1), from the top 23 bits.
+    constexpr float bipolar(uint32_t seed, uint32_t counter) {
+        return std::bit_cast<float>(0x40000000u | (at(seed, counter) >> 9)) - 3.0f;
+    }
+
+    // Per-voice stream, copyable and cheap to reseed.
+    struct Stream {
+        uint32_t seed = 0;
+        uint32_t counter = 0;
+
+        float next_unit() {
+            return unit(seed, counter++);
+        }
+
+        float next_bipolar() {
+            return bipolar(seed, counter++);
+        }
+
+        // Writes the next n bipolar values, each one depends only on its own counter so the loop vectorises.
+        void fill_bipolar(float* out, int n) {
+            const uint32_t base = counter;
+            for (int i = 0; i < n; ++i) {
+                out[i] = bipolar(seed, base + static_cast<uint32_t>(i));
+            }
+            counter += static_cast<uint32_t>(n);
+        }
+    };
+}
+
+#endif //RNG_H
@@ -0,0 +1,269 @@
+#include "Tuning.h"
+
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace audio::tuning {
+    namespace {
+        std::atomic<const piano::FrequencyTable*> active_table{&piano::equal_temperament};
+
+        // Published tables are never freed, the audio thread may still be reading an older one.
+        // They are 512 bytes each and only created when the user loads a tuning.
+        std::mutex publish_mutex;
+        std::vector<std::unique_ptr<piano::FrequencyTable>> published_tables;
+
+        bool fail(std::string* error, const std::string& message) {
+            if (error) {
+                *error = message;
+            }
+            return false;
+        }
+
+        std::string_view trim(std::string_view line) {
+            while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) line.remove_prefix(1);
+            while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r')) line.remove_suffix(1);
+            return line;
+        }
+
+        std::string_view first_token(std::string_view line) {
+            line = trim(line);
+            size_t end = line.find_first_of(" \t");
+            return end == std::string_view::npos ? line : line.substr(0, end);
+        }
+
+        // Splits into lines, dropping '!' comment lines. Blank lines are kept since a .scl description may be empty.
+        std::vector<std::string_view> content_lines(std::string_view text) {
+            std::vector<std::string_view> lines;
+            while (!text.empty()) {
+                size_t end = text.find('\n');
+                std::string_view line = text.substr(0, end);
+                text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+                if (!line.empty() && line.front() == '!') {
+                    continue;
+                }
+                lines.push_back(line);
+            }
+            return lines;
+        }
+
+        std::optional<long> parse_int(std::string_view token) {
+            long value = 0;
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+            if (ec != std::errc() || ptr != token.data() + token.size()) {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        std::optional<double> parse_double(std::string_view token) {
+            std::string owned(token);
+            char* end = nullptr;
+            double value = std::strtod(owned.c_str(), &end);
+            if (owned.empty() || end != owned.c_str() + owned.size()) {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        // A pitch line is either cents (has a '.') or a ratio (n/d or n), anything after the value is ignored.
+        std::optional<double> parse_pitch(std::string_view line) {
+            std::string_view token = first_token(line);
+            if (token.find('.') != std::string_view::npos) {
+                return parse_double(token);
+            }
+
+            size_t slash = token.find('/');
+            auto numerator = parse_int(token.substr(0, slash));
+            auto denominator = slash == std::string_view::npos ? std::optional<long>(1) : parse_int(token.substr(slash + 1));
+            if (!numerator || !denominator || *numerator <= 0 || *denominator <= 0) {
+                return std::nullopt;
+            }
+            return 1200.0 * std::log2(static_cast<double>(*numerator) / static_cast<double>(*denominator));
+        }
+
+        std::optional<std::string> read_file(const std::string& path, std::string* error) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                fail(error, "Could not open " + path);
+                return std::nullopt;
+            }
+            std::stringstream contents;
+            contents << file.rdbuf();
+            return contents.str();
+        }
+
+        int floor_div(int a, int b) {
+            int q = a / b;
+            return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+        }
+
+        // Cents of any (possibly negative or multi-period) scale degree.
+        double degree_cents(const Scale& scale, int degree) {
+            const int size = static_cast<int>(scale.cents.size());
+            const int period = floor_div(degree, size);
+            const int step = degree - period * size;
+            return period * scale.cents.back() + (step == 0 ? 0.0 : scale.cents[step - 1]);
+        }
+    }
+
+    std::optional<Scale> parse_scl(std::string_view text, std::string* error) {
+        auto lines = content_lines(text);
+        if (lines.size() < 2) {
+            fail(error, "Scale is missing its description or note count");
+            return std::nullopt;
+        }
+
+        Scale scale;
+        scale.description = std::string(trim(lines[0]));
+
+        auto count = parse_int(first_token(lines[1]));
+        if (!count || *count <= 0) {
+            fail(error, "Scale note count must be a positive number");
+            return std::nullopt;
+        }
+
+        for (size_t i = 2; i < lines.size() && static_cast<long>(scale.cents.size()) < *count; ++i) {
+            if (trim(lines[i]).empty()) {
+                continue;
+            }
+            auto cents = parse_pitch(lines[i]);
+            if (!cents) {
+                fail(error, "Invalid pitch: " + std::string(trim(lines[i])));
+                return std::nullopt;
+            }
+            scale.cents.push_back(*cents);
+        }
+
+        if (static_cast<long>(scale.cents.size()) != *count) {
+            fail(error, "Scale has fewer pitches than its note count");
+            return std::nullopt;
+        }
+        if (scale.cents.back() <= 0.0) {
+            fail(error, "Scale period must be above 1/1");
+            return std::nullopt;
+        }
+        return scale;
+    }
+
+    std::optional<KeyboardMapping> parse_kbm(std::string_view text, std::string* error) {
+        std::vector<std::string_view> tokens;
+        for (auto line : content_lines(text)) {
+            if (!trim(line).empty()) {
+                tokens.push_back(first_token(line));
+            }
+        }
+        if (tokens.size() < 7) {
+            fail(error, "Keyboard mapping header is incomplete");
+            return std::nullopt;
+        }
+
+        auto map_size = parse_int(tokens[0]);
+        auto first = parse_int(tokens[1]);
+        auto last = parse_int(tokens[2]);
+        auto middle = parse_int(tokens[3]);
+        auto reference = parse_int(tokens[4]);
+        auto frequency = parse_double(tokens[5]);
+        auto octave = parse_int(tokens[6]);
+        if (!map_size || !first || !last || !middle || !reference || !frequency || !octave ||
+            *map_size < 0 || *frequency <= 0.0 || *octave < 0 ||
+            *reference < 0 || *reference > 127 || *first < 0 || *last > 127 || *first > *last) {
+            fail(error, "Keyboard mapping header has an invalid value");
+            return std::nullopt;
+        }
+
+        KeyboardMapping mapping;
+        mapping.first_note = static_cast<int>(*first);
+        mapping.last_note = static_cast<int>(*last);
+        mapping.middle_note = static_cast<int>(*middle);
+        mapping.reference_note = static_cast<int>(*reference);
+        mapping.reference_frequency = *frequency;
+        mapping.octave_degree = static_cast<int>(*octave);
+
+        // Trailing entries may be left out, those keys are unmapped
+        mapping.mapping.assign(static_cast<size_t>(*map_size), -1);
+        for (size_t i = 0; i < mapping.mapping.size() && 7 + i < tokens.size(); ++i) {
+            if (tokens[7 + i] == "x" || tokens[7 + i] == "X") {
+                continue;
+            }
+            auto degree = parse_int(tokens[7 + i]);
+            if (!degree || *degree < 0) {
+                fail(error, "Invalid keyboard mapping entry: " + std::string(tokens[7 + i]));
+                return std::nullopt;
+            }
+            mapping.mapping[i] = static_cast<int>(*degree);
+        }
+        return mapping;
+    }
+
+    std::optional<Scale> load_scl(const std::string& path, std::string* error) {
+        auto text = read_file(path, error);
+        return text ? parse_scl(*text, error) : std::nullopt;
+    }
+
+    std::optional<KeyboardMapping> load_kbm(const std::string& path, std::string* error) {
+        auto text = read_file(path, error);
+        return text ? parse_kbm(*text, error) : std::nullopt;
+    }
+
+    piano::FrequencyTable build_table(const Scale& scale, const KeyboardMapping& mapping) {
+        if (scale.cents.empty()) {
+            return piano::equal_temperament;
+        }
+
+        const int map_size = static_cast<int>(mapping.mapping.size());
+        const int octave_degree = mapping.octave_degree > 0 ? mapping.octave_degree : static_cast<int>(scale.cents.size());
+
+        // Scale degree for a key, or nullopt when the key is unmapped
+        auto key_degree = [&](int key) -> std::optional<int> {
+            const int distance = key - mapping.middle_note;
+            if (map_size == 0) {
+                return distance;
+            }
+            const int octaves = floor_div(distance, map_size);
+            const int entry = mapping.mapping[distance - octaves * map_size];
+            if (entry < 0) {
+                return std::nullopt;
+            }
+            return octaves * octave_degree + entry;
+        };
+
+        // The reference key sounds at the reference frequency even when it is unmapped itself
+        const auto reference_degree = key_degree(mapping.reference_note);
+        const double reference_cents = reference_degree ? degree_cents(scale, *reference_degree) : 0.0;
+
+        piano::FrequencyTable table{};
+        for (int key = mapping.first_note; key <= mapping.last_note; ++key) {
+            auto degree = key_degree(key);
+            if (!degree) {
+                continue;
+            }
+            const double cents = degree_cents(scale, *degree) - reference_cents;
+            table[key] = static_cast<float>(mapping.reference_frequency * std::exp2(cents / 1200.0));
+        }
+        return table;
+    }
+
+    void publish(const piano::FrequencyTable& table) {
+        std::lock_guard lock(publish_mutex);
+        published_tables.push_back(std::make_unique<piano::FrequencyTable>(table));
+        active_table.store(published_tables.back().get(), std::memory_order_release);
+    }
+
+    void reset_to_equal_temperament() {
+        active_table.store(&piano::equal_temperament, std::memory_order_release);
+    }
+
+    float frequency(int midi_note) {
+        if (midi_note < 0 || midi_note >= static_cast<int>(piano::equal_temperament.size())) {
+            return 0.0f;
+        }
+        return (*active_table.load(std::memory_order_acquire))[midi_note];
+    }
+
+} // audio::tuning
@@ -0,0 +1,49 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "audio/piano.h"
+
+namespace audio::tuning {
+
+    // A Scala .scl scale, degree 0 (1/1) is implicit and the last entry is the period.
+    struct Scale {
+        std::string description;
+        std::vector<double> cents;
+    };
+
+    // A Scala .kbm keyboard mapping, an empty mapping maps every key to the next scale degree.
+    struct KeyboardMapping {
+        int first_note = 0;
+        int last_note = 127;
+        int middle_note = 60; // Key that plays scale degree 0
+        int reference_note = 69;
+        double reference_frequency = 440.0;
+        int octave_degree = 0; // Scale degree of the formal octave, 0 means the scale size
+        std::vector<int> mapping; // Scale degree per key, -1 for unmapped keys
+    };
+
+    // Parsers return std::nullopt and fill error (when given) for malformed input.
+    std::optional<Scale> parse_scl(std::string_view text, std::string* error = nullptr);
+    std::optional<KeyboardMapping> parse_kbm(std::string_view text, std::string* error = nullptr);
+
+    std::optional<Scale> load_scl(const std::string& path, std::string* error = nullptr);
+    std::optional<KeyboardMapping> load_kbm(const std::string& path, std::string* error = nullptr);
+
+    // Precomputes the scale into one frequency per MIDI note, unmapped keys get 0 Hz.
+    piano::FrequencyTable build_table(const Scale& scale, const KeyboardMapping& mapping = {});
+
+    // Swaps the table note on reads from, safe to call from the UI while the audio thread is running.
+    void publish(const piano::FrequencyTable& table);
+    void reset_to_equal_temperament();
+
+    // Single atomic load plus an index, for use on the audio thread.
+    float frequency(int midi_note);
+
+} // audio::tuning
+
+#endif //TUNING_H
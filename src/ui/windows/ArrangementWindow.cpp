@@ -0,0 +1,99 @@
+#include "ArrangementWindow.h"
+
+#include <algorithm>
+
+namespace ui {
+namespace Windows {
+    namespace {
+        constexpr uint64_t ticks_per_bar = 4 * audio::Sequencing::TempoMap::ticks_per_quarter;
+
+        uint64_t bars_to_ticks(float bars) {
+            return static_cast<uint64_t>(std::max(bars, 0.0f) * ticks_per_bar);
+        }
+
+        float ticks_to_bars(uint64_t ticks) {
+            return static_cast<float>(ticks) / ticks_per_bar;
+        }
+    }
+
+    void ArrangementWindow::OnRender(mu_Context *ctx) {
+        auto& sequencer = backend->sequencer_state;
+
+        int cw[] = {-1};
+        mu_layout_row(ctx, 1, cw, 0);
+
+        if (sequencer.patterns.empty()) {
+            mu_label(ctx, "No patterns available.");
+            return;
+        }
+
+        mu_popup_selector(
+            ctx,
+            "Arrangement Pattern",
+            "Pattern",
+            sequencer.patterns,
+            [](const audio::Sequencing::Pattern& p) {
+                return quick_format("Pattern {}", p.id);
+            },
+            [](long id) {
+                return quick_format("Pattern {}", id);
+            },
+            [](const audio::Sequencing::Pattern& p) -> long {
+                return p.id;
+            },
+            selected_pattern
+        );
+
+        int width = (mu_get_current_container(ctx)->body.w - ctx->style->padding) / 2;
+        int fcw[] = {width, -1};
+        mu_layout_row(ctx, 2, fcw, 0);
+        mu_label(ctx, "Start bar:");
+        mu_number(ctx, &start_bar, 1.0f);
+        mu_label(ctx, "Length (bars):");
+        mu_number(ctx, &length_bars, 1.0f);
+        mu_label(ctx, "Pattern offset (bars):");
+        mu_number(ctx, &offset_bars, 0.25f);
+
+        mu_layout_row(ctx, 1, cw, 0);
+        if (mu_button(ctx, "Place Instance") && selected_pattern != -1) {
+            audio::Sequencing::PatternInstance instance;
+            instance.pattern_id = static_cast<int>(selected_pattern);
+            instance.start = bars_to_ticks(start_bar - 1.0f);
+            instance.length = bars_to_ticks(length_bars);
+            instance.offset = bars_to_ticks(offset_bars);
+            sequencer.record_undo();
+            {
+                auto lock = sequencer.lock_patterns();
+                sequencer.arrangement.instances.push_back(instance);
+            }
+            sequencer.mark_arrangement_dirty();
+        }
+
+        UI_SEPARATOR(ctx);
+
+        int lcw[] = {-80, -1};
+        mu_layout_row(ctx, 2, lcw, 0);
+        auto& instances = sequencer.arrangement.instances;
+        for (size_t i = 0; i < instances.size(); ++i) {
+            const auto& instance = instances[i];
+            mu_label(ctx, quick_format("Pattern {} @ bar {:.2f}, {:.2f} bars",
+                                       instance.pattern_id,
+                                       ticks_to_bars(instance.start) + 1.0f,
+                                       ticks_to_bars(instance.length)));
+
+            mu_push_id(ctx, &i, sizeof(i));
+            if (mu_button(ctx, "Remove")) {
+                sequencer.record_undo();
+                {
+                    auto lock = sequencer.lock_patterns();
+                    instances.erase(instances.begin() + static_cast<std::ptrdiff_t>(i));
+                }
+                sequencer.mark_arrangement_dirty();
+                mu_pop_id(ctx);
+                break;
+            }
+            mu_pop_id(ctx);
+        }
+    }
+} // Windows
+} // ui
@@ -0,0 +1,35 @@
+#ifndef ARRANGEMENTWINDOW_H
+#define ARRANGEMENTWINDOW_H
+#include "audio/AudioBackend.h"
+#include "ui/Window.h"
+
+extern "C" {
+#include <microui.h>
+}
+
+#include "ui/ui_macros.h"
+
+namespace ui {
+namespace Windows {
+
+// Places pattern instances along the song, positions are edited in bars (4/4).
+class ArrangementWindow final : public ui::Window {
+public:
+    ArrangementWindow(audio::AudioBackend* backend) : ui::Window("Arrangement", mu_rect(320, 10, 280, 390)), backend(backend) {
+    }
+
+protected:
+    void OnRender(mu_Context *ctx) override;
+private:
+    audio::AudioBackend* backend;
+    int64_t selected_pattern = -1;
+
+    float start_bar = 1.0f;
+    float length_bars = 4.0f;
+    float offset_bars = 0.0f;
+};
+
+} // Windows
+} // ui
+
+#endif //ARRANGEMENTWINDOW_H
@@ -1,6 +1,9 @@
 #include "GeneratorManagerWindow.h"
 
+#include "ParameterSlider.h"
 #include "audio/Generators/WaveformGenerator.h"
+#include <atomic>
+#include <type_traits>
 #include <fmt/format.h>
 
 namespace ui {
@@ -18,8 +21,8 @@ void GeneratorManagerWindow::OnRender(mu_Context *ctx) {
 
     mu_label(ctx, quick_format("Voices {}", gen->voices.size()));
 
-    mu_slider_ex(ctx, &gen->volume, 0.0f, 1.0f, 0.01f, "Volume %.2f", 0);
-    mu_slider_ex(ctx, &gen->pan, -1.0f, 1.0f, 0.01f, "Pan %.2f", 0);
+    ParameterSlider(ctx, gen->parameters, "Volume", 0.01f, "Volume %.2f");
+    ParameterSlider(ctx, gen->parameters, "Pan", 0.01f, "Pan %.2f");
 
     if (auto waveformGen = dynamic_cast<audio::Generators::WaveformGenerator*>(gen)) {
         // int cw_freq[] = { - mu_get_current_container(ctx)->body.w / 2 - ctx->style->padding * 2, -1 };
@@ -27,15 +30,156 @@ void GeneratorManagerWindow::OnRender(mu_Context *ctx) {
         mu_layout_row(ctx, 1, cw, 0);
 
         mu_const_popup_selector(ctx, "Change Waveform", "Waveform", audio::waveform::all_waveforms, audio::waveform::to_string, waveformGen->waveform);
-        mu_slider_ex(ctx, &waveformGen->attack, 0.01f, 10.0f, 0.01f, "Attack %.2f s", 0);
-        mu_slider_ex(ctx, &waveformGen->decay, 0.01f, 10.0f, 0.01f, "Decay %.2f s", 0);
-        mu_slider_ex(ctx, &waveformGen->sustain, 0.0f, 1.0f, 0.01f, "Sustain %.2f", 0);
-        mu_slider_ex(ctx, &waveformGen->release, 0.01f, 10.0f, 0.01f, "Release %.2f s", 0);
+        ParameterSlider(ctx, gen->parameters, "Attack", 0.01f, "Attack %.2f s");
+        ParameterSlider(ctx, gen->parameters, "Decay", 0.01f, "Decay %.2f s");
+        ParameterSlider(ctx, gen->parameters, "Sustain", 0.01f, "Sustain %.2f");
+        ParameterSlider(ctx, gen->parameters, "Release", 0.01f, "Release %.2f s");
 
         float unison = static_cast<float>(waveformGen->unison);
         mu_slider_ex(ctx, &unison, 1.0f, 16.0f, 1.0f, "Unison %.0f", 0);
         waveformGen->unison = static_cast<int>(lroundf(unison));
-        mu_slider_ex(ctx, &waveformGen->phase_randomization, 0.0f, 2.0f * M_PI, 0.01f, "Phase Randomization %.2f rad", 0);
+        ParameterSlider(ctx, gen->parameters, "Phase Randomization", 0.01f, "Phase Randomization %.2f rad");
+    }
+
+    RenderNoteEffects(ctx, gen->effects);
+    RenderMidiLearn(ctx, gen);
+}
+
+void GeneratorManagerWindow::RenderMidiLearn(mu_Context *ctx, audio::AudioGenerator *gen) {
+    int cw[] = {-1};
+    mu_layout_row(ctx, 1, cw, 0);
+    mu_label(ctx, "MIDI Learn");
+
+    auto& learn = backend->midi_manager.learn;
+    auto& parameters = gen->parameters;
+    if (parameters.size() == 0) {
+        return;
+    }
+    learn_parameter = std::clamp(learn_parameter, 0, static_cast<int>(parameters.size()) - 1);
+    const audio::Parameter& parameter = parameters[learn_parameter];
+
+    if (mu_button(ctx, quick_format("Parameter: {}", parameter.name))) {
+        learn_parameter = (learn_parameter + 1) % static_cast<int>(parameters.size());
+        learn_min = parameters[learn_parameter].min;
+        learn_max = parameters[learn_parameter].max;
+        learning = false;
+    }
+    mu_slider_ex(ctx, &learn_min, parameter.min, parameter.max, 0.0f, "Min %.2f", 0);
+    mu_slider_ex(ctx, &learn_max, parameter.min, parameter.max, 0.0f, "Max %.2f", 0);
+    mu_slider_ex(ctx, &learn_curve, 0.1f, 4.0f, 0.01f, "Curve %.2f", 0);
+
+    uint8_t device = 0;
+    uint8_t channel = 0;
+    uint8_t controller = 0;
+    if (mu_button(ctx, learning ? "Move a controller..." : "Learn")) {
+        learning = !learning;
+        (void)learn.take_last_controller(device, channel, controller); // Only a controller moved from now on counts
+    }
+    if (learning && learn.take_last_controller(device, channel, controller)) {
+        learn.assign({device, channel, controller, gen, static_cast<uint16_t>(learn_parameter), learn_min, learn_max, learn_curve});
+        learning = false;
+    }
+
+    // This generator's mappings, removing one drops every controller on that parameter
+    int row_cw[] = {-60, -1};
+    const auto& mappings = learn.get_mappings();
+    for (size_t i = 0; i < mappings.size(); ++i) {
+        const auto& mapping = mappings[i];
+        if (mapping.generator != gen) {
+            continue;
+        }
+        mu_layout_row(ctx, 2, row_cw, 0);
+        mu_label(ctx, quick_format("CC {} ch {} dev {} -> {}", mapping.controller, mapping.channel + 1, mapping.device, parameters[mapping.parameter].name));
+        mu_push_id(ctx, &i, sizeof(i));
+        const bool removed = mu_button(ctx, "Remove");
+        mu_pop_id(ctx);
+        if (removed) {
+            learn.remove(gen, mapping.parameter); // Publishes a new table, stop walking this one
+            break;
+        }
+    }
+}
+
+namespace {
+    // Slider for a note effect setting. Like ParameterSlider it edits a copy, the audio thread loads the setting
+    // once per block, so it is only stored when the slider moved.
+    template<typename T>
+    void EffectSlider(mu_Context *ctx, std::atomic<T>& setting, float low, float high, float step, const char* format) {
+        float value = static_cast<float>(setting.load(std::memory_order_relaxed));
+        const std::atomic<T>* id = &setting;
+        mu_push_id(ctx, &id, sizeof(id)); // The copy lives on the stack, the setting keeps the id stable
+        if (mu_slider_ex(ctx, &value, low, high, step, format, 0) & MU_RES_CHANGE) {
+            if constexpr (std::is_floating_point_v<T>) {
+                setting.store(value, std::memory_order_relaxed);
+            } else {
+                setting.store(static_cast<T>(lroundf(value)), std::memory_order_relaxed);
+            }
+        }
+        mu_pop_id(ctx);
+    }
+}
+
+void GeneratorManagerWindow::RenderNoteEffects(mu_Context *ctx, audio::midi::NoteEffectChain &effects) {
+    int cw[] = {-1};
+    mu_layout_row(ctx, 1, cw, 0);
+    mu_label(ctx, "Note Effects");
+
+    // Switching an effect off ends the notes it holds, so it can be toggled while playing
+    auto toggle = [ctx](const char* label, audio::midi::NoteEffect& effect) {
+        int enabled = effect.enabled.load(std::memory_order_relaxed) ? 1 : 0;
+        const audio::midi::NoteEffect* id = &effect;
+        mu_push_id(ctx, &id, sizeof(id));
+        if (mu_checkbox(ctx, label, &enabled) & MU_RES_CHANGE) {
+            effect.enabled.store(enabled != 0, std::memory_order_relaxed);
+        }
+        mu_pop_id(ctx);
+        return enabled != 0;
+    };
+
+    if (toggle("Transpose", effects.transpose)) {
+        EffectSlider(ctx, effects.transpose.semitones, -24.0f, 24.0f, 1.0f, "Semitones %.0f");
+    }
+
+    if (toggle("Chord", effects.chord)) {
+        auto& chord = effects.chord;
+        const size_t count = chord.interval_count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            EffectSlider(ctx, chord.intervals[i], -12.0f, 24.0f, 1.0f, "Interval %.0f");
+        }
+        EffectSlider(ctx, chord.interval_count, 1.0f, static_cast<float>(audio::midi::Chord::max_intervals), 1.0f, "Notes added %.0f");
+    }
+
+    if (toggle("Arpeggiator", effects.arpeggiator)) {
+        auto& arp = effects.arpeggiator;
+        constexpr const char* modes[] = {"Up", "Down", "Up/Down", "As Played"};
+        const int mode = static_cast<int>(arp.mode.load(std::memory_order_relaxed));
+        if (mu_button(ctx, quick_format("Mode: {}", modes[mode]))) {
+            arp.mode.store(static_cast<audio::midi::Arpeggiator::Mode>((mode + 1) % 4), std::memory_order_relaxed);
+        }
+        EffectSlider(ctx, arp.steps_per_quarter, 1.0f, 16.0f, 1.0f, "Steps per beat %.0f");
+        EffectSlider(ctx, arp.gate, 0.05f, 1.0f, 0.01f, "Gate %.2f");
+        EffectSlider(ctx, arp.octaves, 1.0f, 4.0f, 1.0f, "Octaves %.0f");
+    }
+
+    if (toggle("Note Repeat", effects.repeat)) {
+        EffectSlider(ctx, effects.repeat.steps_per_quarter, 1.0f, 16.0f, 1.0f, "Steps per beat %.0f");
+        EffectSlider(ctx, effects.repeat.gate, 0.05f, 1.0f, 0.01f, "Gate %.2f");
+    }
+
+    if (toggle("Velocity Curve", effects.velocity)) {
+        auto& velocity = effects.velocity;
+        EffectSlider(ctx, velocity.curve, 0.1f, 4.0f, 0.01f, "Curve %.2f");
+        float low = velocity.min.load(std::memory_order_relaxed);
+        float high = velocity.max.load(std::memory_order_relaxed);
+        const audio::midi::VelocityCurve* id = &velocity;
+        mu_push_id(ctx, &id, sizeof(id));
+        int changed = mu_slider_ex(ctx, &low, 1.0f, 127.0f, 1.0f, "Min %.0f", 0);
+        changed |= mu_slider_ex(ctx, &high, 1.0f, 127.0f, 1.0f, "Max %.0f", 0);
+        mu_pop_id(ctx);
+        if (changed & MU_RES_CHANGE) {
+            velocity.min.store(static_cast<uint8_t>(lroundf(std::min(low, high))), std::memory_order_relaxed);
+            velocity.max.store(static_cast<uint8_t>(lroundf(std::max(low, high))), std::memory_order_relaxed);
+        }
     }
 }
 } // Windows
@@ -22,6 +22,16 @@ private:
     GeneratorsWindow* generators_window;
     audio::AudioBackend* backend;
 
+    // MIDI learn for the parameter picked here, learning until a controller moves
+    int learn_parameter = 0;
+    float learn_min = 0.0f;
+    float learn_max = 1.0f;
+    float learn_curve = 1.0f;
+    bool learning = false;
+
+    void RenderNoteEffects(mu_Context *ctx, audio::midi::NoteEffectChain &effects);
+    void RenderMidiLearn(mu_Context *ctx, audio::AudioGenerator *gen);
+
 };
 } // Windows
 } // ui
@@ -1,5 +1,7 @@
 #include "GeneratorsWindow.h"
 
+#include "ParameterSlider.h"
+
 #include <iostream>
 #include <fmt/format.h>
 
@@ -21,7 +23,7 @@ void GeneratorsWindow::OnRender(mu_Context *ctx) {
                                 is_selected,
                                 gen->name));
 
-        mu_slider_ex(ctx, &gen->volume, 0.0f, 1.0f, 0.01f, "vol %.2f", 0);
+        ParameterSlider(ctx, gen->parameters, "Volume", 0.01f, "vol %.2f");
 
         mu_push_id(ctx, &idx, sizeof(int));
         if (mu_button(ctx, "Select")) {
@@ -0,0 +1,32 @@
+#ifndef PARAMETERSLIDER_H
+#define PARAMETERSLIDER_H
+
+extern "C" {
+#include <microui.h>
+}
+
+#include "audio/ParameterStore.h"
+
+namespace ui {
+namespace Windows {
+
+// Slider for a generator parameter. It edits a copy, the audio thread owns the generator's field and picks the
+// change up from the parameter queue, like a MIDI controller's.
+inline void ParameterSlider(mu_Context *ctx, audio::ParameterStore& parameters, const char* name, float step, const char* format) {
+    const int index = parameters.find(name);
+    if (index < 0) {
+        return;
+    }
+    const audio::Parameter* parameter = &parameters[index];
+    float value = parameters.get(index);
+    mu_push_id(ctx, &parameter, sizeof(parameter)); // The copy lives on the stack, the parameter keeps the id stable
+    if (mu_slider_ex(ctx, &value, parameter->min, parameter->max, step, format, 0) & MU_RES_CHANGE) {
+        parameters.queue(static_cast<uint16_t>(index), value);
+    }
+    mu_pop_id(ctx);
+}
+
+} // Windows
+} // ui
+
+#endif //PARAMETERSLIDER_H
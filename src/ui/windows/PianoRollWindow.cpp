@@ -1,6 +1,7 @@
 #include "PianoRollWindow.h"
 
 #include "audio/piano.h"
+#include "audio/midi/MidiFile.h"
 
 namespace ui {
 namespace Windows {
@@ -36,15 +37,25 @@ namespace Windows {
         mu_layout_row(ctx, 2, button_cw, 0);
 
         if (mu_button(ctx, "Add Pattern")) {
+            backend->sequencer_state.record_undo();
             audio::Sequencing::Pattern new_pattern;
             new_pattern.id = backend->sequencer_state.id_counter++;
             new_pattern.note_sequences.emplace_back();
-            backend->sequencer_state.patterns.push_back(new_pattern);
+            {
+                auto lock = backend->sequencer_state.lock_patterns();
+                backend->sequencer_state.patterns.push_back(new_pattern);
+                // Place it once at the start of the song (4 bars), more instances go through the arrangement window
+                backend->sequencer_state.arrangement.instances.push_back({new_pattern.id, 0, 16 * audio::Sequencing::TempoMap::ticks_per_quarter, 0});
+            }
+            backend->sequencer_state.mark_dirty(new_pattern.id);
+            backend->sequencer_state.mark_arrangement_dirty();
             selected_pattern = new_pattern.id;
         }
 
         if (mu_button(ctx, "Remove Pattern")) {
+            backend->sequencer_state.record_undo();
             // Find the pattern with the selected ID and remove it
+            auto lock = backend->sequencer_state.lock_patterns();
             auto it = std::remove_if(backend->sequencer_state.patterns.begin(),
                                      backend->sequencer_state.patterns.end(),
                                      [this](const audio::Sequencing::Pattern& p) {
@@ -54,12 +65,79 @@ namespace Windows {
             // If we found a pattern to remove, erase it
             if (it != backend->sequencer_state.patterns.end()) {
                 backend->sequencer_state.patterns.erase(it, backend->sequencer_state.patterns.end());
+                std::erase_if(backend->sequencer_state.arrangement.instances, [this](const audio::Sequencing::PatternInstance& instance) {
+                    return instance.pattern_id == selected_pattern;
+                });
+                backend->sequencer_state.mark_dirty(static_cast<int>(selected_pattern));
+                backend->sequencer_state.mark_arrangement_dirty();
                 selected_pattern = -1; // Reset selection
             } else {
                 mu_label(ctx, "Pattern not found.");
             }
         }
 
+        // Clone and undo/redo, all cheap since copies share their note chunks until edited
+        int history_width = (mu_get_current_container(ctx)->body.w - 2 * ctx->style->padding) / 3;
+        int history_cw[] = {history_width, history_width, -1};
+        mu_layout_row(ctx, 3, history_cw, 0);
+
+        if (mu_button(ctx, "Clone Pattern") && selected_pattern != -1) {
+            backend->sequencer_state.record_undo();
+            int clone_id = -1;
+            {
+                auto lock = backend->sequencer_state.lock_patterns();
+                auto& patterns = backend->sequencer_state.patterns;
+                auto it = std::find_if(patterns.begin(), patterns.end(), [this](const audio::Sequencing::Pattern& p) {
+                    return p.id == selected_pattern;
+                });
+                if (it != patterns.end()) {
+                    audio::Sequencing::Pattern clone = *it;
+                    clone.id = clone_id = backend->sequencer_state.id_counter++;
+                    clone.name = it->name + " (copy)";
+                    patterns.push_back(std::move(clone));
+                }
+            }
+            if (clone_id != -1) {
+                backend->sequencer_state.mark_dirty(clone_id);
+                selected_pattern = clone_id;
+            }
+        }
+
+        if (mu_button(ctx, "Undo")) {
+            backend->sequencer_state.undo();
+        }
+
+        if (mu_button(ctx, "Redo")) {
+            backend->sequencer_state.redo();
+        }
+
+        RenderMidiFile(ctx);
+
+        // Groove of the selected pattern, baked in when it compiles so the notes stay on the grid
+        if (selected_pattern != -1) {
+            int groove_cw[] = {60, -100, -1};
+            mu_layout_row(ctx, 3, groove_cw, 0);
+            mu_label(ctx, "Swing %");
+            mu_number(ctx, &swing_percent, 1.0f);
+            if (mu_button(ctx, "Apply Swing")) {
+                SetGroove(audio::Sequencing::Groove::swing(swing_percent));
+            }
+
+            // Live input goes into the selected pattern while the transport plays
+            auto& recorder = backend->recorder;
+            const bool recording = recorder.get_pattern() == selected_pattern;
+            int record_cw[] = {100, -1};
+            mu_layout_row(ctx, 2, record_cw, 0);
+            if (mu_button(ctx, recording ? "Stop Recording" : "Record")) {
+                if (recording) {
+                    recorder.disarm();
+                } else {
+                    recorder.arm(static_cast<int>(selected_pattern));
+                }
+            }
+            mu_label(ctx, recording ? quick_format("Recording, {} events dropped", recorder.get_dropped()) : "");
+        }
+
         mu_layout_row(ctx, 1, cw, 0);
 
         if (generators_window->selected_generator == -1) {
@@ -97,9 +175,14 @@ namespace Windows {
                     audio::Sequencing::NoteSequence new_sequence;
                     new_sequence.generator = backend->generators[generators_window->selected_generator];
 
-                    new_sequence.notes.push_back({60, 127, 0, 0, 22050, false});
+                    new_sequence.add_note({0, audio::Sequencing::TempoMap::ticks_per_quarter, 60, 127});
 
-                    it->note_sequences.push_back(new_sequence);
+                    backend->sequencer_state.record_undo();
+                    {
+                        auto lock = backend->sequencer_state.lock_patterns();
+                        it->note_sequences.push_back(new_sequence);
+                    }
+                    backend->sequencer_state.mark_dirty(it->id);
                     mu_open_popup(ctx, "Note Sequence Added Successfully");
                 } else {
                     mu_open_popup(ctx, "Note Sequence Failed To Add");
@@ -127,12 +210,112 @@ namespace Windows {
                                            });
 
                 if (seq_it != pattern.note_sequences.end()) {
+                    // Takes the timing and dynamics of this sequence (e.g. a recorded take) over one bar of 16ths
+                    if (mu_button(ctx, "Use Sequence As Groove")) {
+                        SetGroove(audio::Sequencing::Groove::extract(*seq_it, 16));
+                    }
                     RenderPianoRoll(ctx, *seq_it);
                 }
             }
         }
     }
 
+    void PianoRollWindow::RenderMidiFile(mu_Context *ctx) {
+        int cw[] = {-1};
+        mu_layout_row(ctx, 1, cw, 0);
+        mu_textbox(ctx, midi_path, sizeof(midi_path));
+
+        int button_width = (mu_get_current_container(ctx)->body.w - ctx->style->padding) / 2;
+        int button_cw[] = {button_width, -1};
+        mu_layout_row(ctx, 2, button_cw, 0);
+
+        // Every track becomes a note sequence of a new pattern, on the generators in order
+        if (mu_button(ctx, "Import MIDI")) {
+            std::string error;
+            // Tracks only become note sequences on a generator, with none the pattern would come out empty
+            std::optional<audio::midi::MidiFile> file;
+            if (backend->generators.empty()) {
+                error = "no generator to play the tracks, add one first";
+            } else {
+                file = audio::midi::load_smf(midi_path, &error);
+            }
+            if (file) {
+                backend->sequencer_state.record_undo();
+                uint64_t end = 0;
+                int id = -1;
+                {
+                    auto lock = backend->sequencer_state.lock_patterns();
+                    id = backend->sequencer_state.id_counter++;
+                    auto pattern = audio::midi::to_pattern(*file, {backend->generators.begin(), backend->generators.end()}, id);
+                    for (const auto& track : file->tracks) {
+                        if (!track.notes.empty()) {
+                            end = std::max(end, track.notes.back().end());
+                        }
+                    }
+                    backend->sequencer_state.patterns.push_back(std::move(pattern));
+                    constexpr uint64_t bar = 4 * audio::Sequencing::TempoMap::ticks_per_quarter;
+                    backend->sequencer_state.arrangement.instances.push_back({id, 0, std::max<uint64_t>((end + bar - 1) / bar, 1) * bar, 0});
+                }
+                backend->sequencer_state.mark_dirty(id);
+                backend->sequencer_state.mark_arrangement_dirty();
+
+                if (!file->tempo.empty()) {
+                    audio::Sequencing::TempoMap tempo;
+                    for (const auto& change : file->tempo) {
+                        tempo.set_tempo(change.tick, change.bpm);
+                    }
+                    backend->sequencer_state.set_tempo_map(tempo);
+                }
+                selected_pattern = id;
+                midi_status = fmt::format("Imported {} tracks", file->tracks.size());
+            } else {
+                midi_status = "Error: " + error;
+            }
+        }
+
+        if (mu_button(ctx, "Export MIDI") && selected_pattern != -1) {
+            const auto tempo = backend->sequencer_state.get_tempo_map();
+            std::optional<audio::midi::MidiFile> file;
+            {
+                auto lock = backend->sequencer_state.lock_patterns();
+                auto& patterns = backend->sequencer_state.patterns;
+                auto it = std::find_if(patterns.begin(), patterns.end(), [this](const audio::Sequencing::Pattern& p) {
+                    return p.id == selected_pattern;
+                });
+                if (it != patterns.end()) {
+                    file = audio::midi::from_pattern(*it, tempo);
+                }
+            }
+            std::string error;
+            if (file && audio::midi::save_smf(midi_path, *file, &error)) {
+                midi_status = fmt::format("Exported {} tracks", file->tracks.size());
+            } else {
+                midi_status = "Error: " + (file ? error : std::string("pattern not found"));
+            }
+        }
+
+        mu_layout_row(ctx, 1, cw, 0);
+        if (!midi_status.empty()) {
+            mu_label(ctx, midi_status.c_str());
+        }
+    }
+
+    void PianoRollWindow::SetGroove(const audio::Sequencing::Groove& groove) {
+        backend->sequencer_state.record_undo();
+        {
+            auto lock = backend->sequencer_state.lock_patterns();
+            auto& patterns = backend->sequencer_state.patterns;
+            auto it = std::find_if(patterns.begin(), patterns.end(), [this](const audio::Sequencing::Pattern& p) {
+                return p.id == selected_pattern;
+            });
+            if (it == patterns.end()) {
+                return;
+            }
+            it->groove = groove;
+        }
+        backend->sequencer_state.mark_dirty(static_cast<int>(selected_pattern));
+    }
+
     void PianoRollWindow::RenderPianoRoll(mu_Context* ctx, const audio::Sequencing::NoteSequence& sequence) {
         int cw[] = {-1};
         mu_layout_row(ctx, 1, cw, 0);
@@ -144,7 +327,7 @@ namespace Windows {
 
         // Render the piano roll
         int note_height = 20; // Height of each note row
-        int note_width = 50; // Width of each note column
+        int note_width = 50; // Width of one quarter note
         int num_notes = 128; // Total number of MIDI notes
 
         for (int i = 0; i < num_notes; ++i) {
@@ -152,9 +335,10 @@ namespace Windows {
             mu_draw_rect(ctx, note_rect, mu_color(200, 200, 200, 255)); // Draw background for each note row
         }
         for (const auto& note : sequence.notes) {
-            int note_x = note.play_time / 44100 * note_width; // Convert sample to pixel position
-            int note_y = (127 - note.note_number) * note_height; // Invert pitch for Y position
-            int note_w = (note.stop_time - note.play_time) / 44100 * note_width; // Width based on duration
+            constexpr auto ticks_per_quarter = audio::Sequencing::TempoMap::ticks_per_quarter;
+            int note_x = static_cast<int>(uint64_t{note.tick} * note_width / ticks_per_quarter); // Convert tick to pixel position
+            int note_y = (127 - note.pitch) * note_height; // Invert pitch for Y position
+            int note_w = static_cast<int>(uint64_t{note.length} * note_width / ticks_per_quarter); // Width based on duration
 
             mu_Rect rect = mu_rect(note_x, note_y, note_w, note_height);
             mu_draw_rect(ctx, rect, mu_color(0, 255, 0, 255)); // Draw the note rectangle
@@ -18,8 +18,13 @@ private:
     Windows::GeneratorsWindow* generators_window;
     audio::AudioBackend* backend;
     int64_t selected_pattern = -1; // Currently selected pattern in the piano roll
+    float swing_percent = 50.0f; // Applied to the selected pattern with Apply Swing, 50 is straight
+    char midi_path[256] = {};
+    std::string midi_status;
 
     void RenderPianoRoll(mu_Context *ctx, const audio::Sequencing::NoteSequence &sequence);
+    void SetGroove(const audio::Sequencing::Groove& groove);
+    void RenderMidiFile(mu_Context *ctx);
 };
 
 } // Windows
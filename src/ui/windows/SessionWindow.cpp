@@ -0,0 +1,45 @@
+#include "SessionWindow.h"
+
+#include <algorithm>
+
+namespace ui {
+namespace Windows {
+    void SessionWindow::OnRender(mu_Context *ctx) {
+        auto& sequencer = backend->sequencer_state;
+
+        int cw[] = {-1};
+        mu_layout_row(ctx, 1, cw, 0);
+        mu_checkbox(ctx, "Quantize to beat", &quantize_to_beat);
+        const auto quantize = quantize_to_beat ? audio::Sequencing::SequencerState::Quantize::Beat : audio::Sequencing::SequencerState::Quantize::Bar;
+
+        if (sequencer.patterns.empty() || backend->generators.empty()) {
+            mu_label(ctx, "Add patterns and generators to launch clips.");
+            return;
+        }
+
+        const auto clips = sequencer.get_clips();
+        std::vector<int> row(sequencer.patterns.size() + 2, 40);
+        row[0] = 100;
+        for (auto* generator : backend->generators) {
+            mu_layout_row(ctx, static_cast<int>(row.size()), row.data(), 0);
+            mu_label(ctx, generator->name.c_str());
+
+            mu_push_id(ctx, &generator, sizeof(generator));
+            for (const auto& pattern : sequencer.patterns) {
+                // > playing, * waiting for its launch point
+                auto clip = std::find_if(clips.begin(), clips.end(), [&](const audio::Sequencing::SequencerState::ClipSlot& c) {
+                    return c.generator == generator && c.pattern_id == pattern.id;
+                });
+                const char* state = clip == clips.end() ? "" : clip->playing ? ">" : "*";
+                if (mu_button(ctx, quick_format("{}{}", state, pattern.id))) {
+                    sequencer.launch_clip(generator, pattern.id, quantize);
+                }
+            }
+            if (mu_button(ctx, "Stop")) {
+                sequencer.stop_clip(generator, quantize);
+            }
+            mu_pop_id(ctx);
+        }
+    }
+} // Windows
+} // ui
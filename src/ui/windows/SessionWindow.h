@@ -0,0 +1,31 @@
+#ifndef SESSIONWINDOW_H
+#define SESSIONWINDOW_H
+#include "audio/AudioBackend.h"
+#include "ui/Window.h"
+
+extern "C" {
+#include <microui.h>
+}
+
+#include "ui/ui_macros.h"
+
+namespace ui {
+namespace Windows {
+
+// Clip launcher: a row per generator, a button per pattern. Launches and stops snap to the next bar (or beat).
+class SessionWindow final : public ui::Window {
+public:
+    SessionWindow(audio::AudioBackend* backend) : ui::Window("Session", mu_rect(930, 410, 400, 300)), backend(backend) {
+    }
+
+protected:
+    void OnRender(mu_Context *ctx) override;
+private:
+    audio::AudioBackend* backend;
+    int quantize_to_beat = 0;
+};
+
+} // Windows
+} // ui
+
+#endif //SESSIONWINDOW_H
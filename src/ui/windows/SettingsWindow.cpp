@@ -1,5 +1,10 @@
 #include "SettingsWindow.h"
 
+#include <algorithm>
+
+#include "audio/dsp/DspKernels.h"
+#include "audio/tuning/Tuning.h"
+
 void ui::Windows::SettingsWindow::OnRender(mu_Context *ctx) {
     int cw[1] = {UI_LAYOUT_WIDTH(ctx)};
     mu_layout_row(ctx, 1, cw, 0);
@@ -33,6 +38,147 @@ void ui::Windows::SettingsWindow::OnRender(mu_Context *ctx) {
                                fmt::format("{:02}", seconds),
                                fmt::format("{:03}", milliseconds)));
     mu_label(ctx, quick_format("Current Sample: {}", this->backend->sequencer_state.get_current_sample()));
+    const uint64_t tick = this->backend->sequencer_state.get_current_tick();
+    const uint64_t quarter = tick / audio::Sequencing::TempoMap::ticks_per_quarter;
+    mu_label(ctx, quick_format("Bar {} Beat {}", quarter / 4 + 1, quarter % 4 + 1));
+
+    mu_label(ctx, "Tempo (BPM):");
+    if (mu_number(ctx, &bpm, 1.0f) & MU_RES_CHANGE) {
+        auto tempo = this->backend->sequencer_state.get_tempo_map();
+        tempo.set_tempo(0, bpm);
+        this->backend->sequencer_state.set_tempo_map(tempo);
+    }
+
+    int scw[] = {width * 2, -1}; // Seek target, Seek button
+    mu_layout_row(ctx, 2, scw, 0);
+    mu_number(ctx, &seek_seconds, 0.1f);
+    if (mu_button(ctx, "Seek")) {
+        this->backend->sequencer_state.seek(static_cast<uint64_t>(std::max(seek_seconds, 0.0f) * SAMPLE_RATE));
+    }
+
+    int lcw[] = {width, width, -1}; // Loop toggle, start, end
+    mu_layout_row(ctx, 3, lcw, 0);
+    int loop_changed = mu_checkbox(ctx, "Loop", &loop_enabled);
+    loop_changed |= mu_number(ctx, &loop_start_seconds, 0.1f);
+    loop_changed |= mu_number(ctx, &loop_end_seconds, 0.1f);
+    if (loop_changed & MU_RES_CHANGE) {
+        audio::Sequencing::SequencerState::LoopRegion loop;
+        loop.start = static_cast<uint64_t>(std::max(loop_start_seconds, 0.0f) * SAMPLE_RATE);
+        loop.end = static_cast<uint64_t>(std::max(loop_end_seconds, 0.0f) * SAMPLE_RATE);
+        loop.enabled = loop_enabled != 0;
+        this->backend->sequencer_state.set_loop(loop);
+    }
+    mu_layout_row(ctx, 1, cw, 0);
+
     mu_label(ctx, quick_format("Slice: {}", this->backend->sequencer_state.get_current_slice()));
     mu_label(ctx, quick_format("Bucket: {}", this->backend->sequencer_state.get_current_bucket()));
+    mu_label(ctx, quick_format("DSP kernels: {}", audio::dsp::to_string(audio::dsp::kernels().isa)));
+
+    UI_SEPARATOR(ctx);
+    RenderTuning(ctx);
+
+    UI_SEPARATOR(ctx);
+    RenderMidiRouting(ctx);
+}
+
+void ui::Windows::SettingsWindow::RenderTuning(mu_Context *ctx) {
+    int cw[1] = {UI_LAYOUT_WIDTH(ctx)};
+    mu_layout_row(ctx, 1, cw, 0);
+
+    mu_label(ctx, "Scale (.scl):");
+    mu_textbox(ctx, scl_path, sizeof(scl_path));
+    mu_label(ctx, "Keyboard mapping (.kbm, optional):");
+    mu_textbox(ctx, kbm_path, sizeof(kbm_path));
+
+    int width = mu_get_current_container(ctx)->body.w / 2 - ctx->style->padding;
+    int bcw[] = {width, -1};
+    mu_layout_row(ctx, 2, bcw, 0);
+    if (mu_button(ctx, "Load Tuning")) {
+        std::string error;
+        auto scale = audio::tuning::load_scl(scl_path, &error);
+        std::optional<audio::tuning::KeyboardMapping> mapping = audio::tuning::KeyboardMapping{};
+        if (scale && kbm_path[0] != '\0') {
+            mapping = audio::tuning::load_kbm(kbm_path, &error);
+        }
+
+        if (scale && mapping) {
+            audio::tuning::publish(audio::tuning::build_table(*scale, *mapping));
+            tuning_status = scale->description.empty() ? std::string(scl_path) : scale->description;
+        } else {
+            tuning_status = "Error: " + error;
+        }
+    }
+    if (mu_button(ctx, "Reset to 12-TET")) {
+        audio::tuning::reset_to_equal_temperament();
+        tuning_status = "12-TET";
+    }
+
+    mu_layout_row(ctx, 1, cw, 0);
+    mu_label(ctx, quick_format("Tuning: {}", tuning_status));
+}
+
+void ui::Windows::SettingsWindow::RenderMidiRouting(mu_Context *ctx) {
+    int cw[1] = {UI_LAYOUT_WIDTH(ctx)};
+    mu_layout_row(ctx, 1, cw, 0);
+
+    auto& midi = this->backend->midi_manager;
+    if (mu_button(ctx, "Rescan MIDI Inputs")) {
+        midi.rescan();
+    }
+    // Found in the background and whenever one is plugged in, so this can be empty for a moment after startup
+    const auto devices = midi.GetDevices();
+    if (devices.empty()) {
+        mu_label(ctx, "No MIDI inputs");
+        return;
+    }
+
+    // Every device with its routes, one entry per channel that does not follow the selected generator
+    int dcw[] = {60, -1};
+    for (size_t device = 0; device < devices.size(); ++device) {
+        mu_layout_row(ctx, 2, dcw, 0);
+        int wanted = devices[device].wanted ? 1 : 0;
+        mu_push_id(ctx, &device, sizeof(device));
+        if (mu_checkbox(ctx, "Use", &wanted) & MU_RES_CHANGE) {
+            midi.SetDeviceWanted(device, wanted != 0);
+        }
+        mu_pop_id(ctx);
+
+        std::string routes;
+        for (uint8_t channel = 0; channel < 16; ++channel) {
+            const int generator = midi.routing.get(static_cast<uint8_t>(device), channel);
+            if (generator == audio::midi::MidiRouting::ignored) {
+                routes += fmt::format(" {}:off", channel + 1);
+            } else if (generator != audio::midi::MidiRouting::follow_selection) {
+                routes += fmt::format(" {}:{}", channel + 1, generator);
+            }
+        }
+        const char* state = !devices[device].connected ? " (unplugged)" : devices[device].open ? "" : " (closed)";
+        mu_label(ctx, quick_format("[{}] {}{}{}", device, devices[device].name, state, routes.empty() ? " -> selected" : routes));
+    }
+
+    // Device, channel (1-16) and generator (-1 follows the selection, -2 ignores the channel)
+    int width = mu_get_current_container(ctx)->body.w / 3 - ctx->style->padding;
+    int ncw[] = {width, width, -1};
+    mu_layout_row(ctx, 3, ncw, 0);
+    mu_number(ctx, &route_device, 1.0f);
+    mu_number(ctx, &route_channel, 1.0f);
+    mu_number(ctx, &route_generator, 1.0f);
+
+    route_device = std::clamp(route_device, 0.0f, static_cast<float>(devices.size() - 1));
+    route_channel = std::clamp(route_channel, 1.0f, 16.0f);
+    route_generator = std::clamp(route_generator, -2.0f, static_cast<float>(this->backend->generators.size()) - 1.0f);
+
+    const auto device = static_cast<uint8_t>(route_device);
+    const int generator = static_cast<int>(route_generator);
+    int bcw[] = {width, width, -1};
+    mu_layout_row(ctx, 3, bcw, 0);
+    if (mu_button(ctx, "Route Channel")) {
+        midi.routing.set(device, static_cast<uint8_t>(route_channel) - 1, generator);
+    }
+    if (mu_button(ctx, "Route Device")) {
+        midi.routing.set_device(device, generator);
+    }
+    if (mu_button(ctx, "Reset")) {
+        midi.routing.set_device(device, audio::midi::MidiRouting::follow_selection);
+    }
 }
@@ -1,6 +1,7 @@
 #ifndef SETTINGSWINDOW_H
 #define SETTINGSWINDOW_H
 #include <iostream>
+#include <string>
 
 #include "audio/AudioBackend.h"
 extern "C" {
@@ -19,6 +20,23 @@ protected:
 
 private:
     audio::AudioBackend* backend;
+
+    float bpm = 120.0f;
+    float seek_seconds = 0.0f;
+    int loop_enabled = 0;
+    float loop_start_seconds = 0.0f;
+    float loop_end_seconds = 4.0f;
+
+    char scl_path[256] = {};
+    char kbm_path[256] = {};
+    std::string tuning_status = "12-TET";
+
+    float route_device = 0.0f;
+    float route_channel = 1.0f;
+    float route_generator = -1.0f;
+
+    void RenderTuning(mu_Context *ctx);
+    void RenderMidiRouting(mu_Context *ctx);
 };
 }
 
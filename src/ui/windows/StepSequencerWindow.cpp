@@ -0,0 +1,162 @@
+#include "StepSequencerWindow.h"
+
+#include <algorithm>
+
+namespace ui {
+namespace Windows {
+    void StepSequencerWindow::Edit(audio::AudioGenerator* generator, const std::function<void(audio::Sequencing::StepSequence&)>& edit) {
+        auto& sequencer = backend->sequencer_state;
+        sequencer.record_undo();
+        {
+            auto lock = sequencer.lock_patterns();
+            auto pattern = std::find_if(sequencer.patterns.begin(), sequencer.patterns.end(), [this](const audio::Sequencing::Pattern& p) {
+                return p.id == selected_pattern;
+            });
+            if (pattern == sequencer.patterns.end()) {
+                return;
+            }
+            auto sequence = std::find_if(pattern->step_sequences.begin(), pattern->step_sequences.end(), [generator](const audio::Sequencing::StepSequence& s) {
+                return s.generator == generator;
+            });
+            if (sequence == pattern->step_sequences.end()) {
+                sequence = pattern->step_sequences.emplace(pattern->step_sequences.end());
+                sequence->generator = generator;
+                sequence->add_lane(static_cast<uint8_t>(new_lane_pitch));
+            }
+            edit(*sequence);
+        }
+        sequencer.mark_dirty(static_cast<int>(selected_pattern));
+    }
+
+    void StepSequencerWindow::OnRender(mu_Context *ctx) {
+        auto& sequencer = backend->sequencer_state;
+
+        int cw[] = {-1};
+        mu_layout_row(ctx, 1, cw, 0);
+
+        if (sequencer.patterns.empty()) {
+            mu_label(ctx, "No patterns available.");
+            return;
+        }
+
+        mu_popup_selector(
+            ctx,
+            "Step Pattern",
+            "Pattern",
+            sequencer.patterns,
+            [](const audio::Sequencing::Pattern& p) {
+                return quick_format("Pattern {}", p.id);
+            },
+            [](long id) {
+                return quick_format("Pattern {}", id);
+            },
+            [](const audio::Sequencing::Pattern& p) -> long {
+                return p.id;
+            },
+            selected_pattern
+        );
+
+        if (generators_window->selected_generator == -1) {
+            mu_label(ctx, "No generator selected.");
+            return;
+        }
+
+        auto pattern = std::find_if(sequencer.patterns.begin(), sequencer.patterns.end(), [this](const audio::Sequencing::Pattern& p) {
+            return p.id == selected_pattern;
+        });
+        if (pattern == sequencer.patterns.end()) {
+            return;
+        }
+
+        auto* generator = backend->generators[generators_window->selected_generator];
+        auto sequence = std::find_if(pattern->step_sequences.begin(), pattern->step_sequences.end(), [generator](const audio::Sequencing::StepSequence& s) {
+            return s.generator == generator;
+        });
+
+        int width = (mu_get_current_container(ctx)->body.w - 2 * ctx->style->padding) / 3;
+        int lcw[] = {width, width, -1};
+        mu_layout_row(ctx, 3, lcw, 0);
+        mu_label(ctx, "Lane pitch:");
+        mu_number(ctx, &new_lane_pitch, 1.0f);
+        new_lane_pitch = std::clamp(new_lane_pitch, 0.0f, 127.0f);
+        if (mu_button(ctx, sequence == pattern->step_sequences.end() ? "Add Step Sequence" : "Add Lane")) {
+            const bool existed = sequence != pattern->step_sequences.end();
+            Edit(generator, [this, existed](audio::Sequencing::StepSequence& s) {
+                if (existed) {
+                    s.add_lane(static_cast<uint8_t>(new_lane_pitch));
+                }
+            });
+            return;
+        }
+        if (sequence == pattern->step_sequences.end()) {
+            return;
+        }
+
+        mu_label(ctx, "Steps:");
+        mu_number(ctx, &step_count, 1.0f);
+        step_count = std::clamp(step_count, 1.0f, 256.0f);
+        if (mu_button(ctx, "Resize")) {
+            Edit(generator, [this](audio::Sequencing::StepSequence& s) {
+                s.set_step_count(static_cast<size_t>(step_count));
+            });
+            return;
+        }
+
+        UI_SEPARATOR(ctx);
+
+        // One row per lane: its pitch, then a toggle per step
+        const size_t steps = sequence->step_count();
+        std::vector<int> grid_cw(steps + 1, 18);
+        grid_cw[0] = 40;
+        for (size_t l = 0; l < sequence->lanes.size(); ++l) {
+            const auto& lane = sequence->lanes[l];
+            mu_layout_row(ctx, static_cast<int>(grid_cw.size()), grid_cw.data(), 0);
+            mu_label(ctx, quick_format("{}", lane.pitch));
+            for (size_t s = 0; s < steps; ++s) {
+                const bool active = s < lane.steps.size() && lane.steps[s].is_active();
+                const bool selected = static_cast<int>(l) == selected_lane && static_cast<int>(s) == selected_step;
+                const size_t id = l * steps + s;
+                mu_push_id(ctx, &id, sizeof(id));
+                if (mu_button(ctx, selected ? "o" : active ? "#" : "-")) {
+                    selected_lane = static_cast<int>(l);
+                    selected_step = static_cast<int>(s);
+                    Edit(generator, [l, s](audio::Sequencing::StepSequence& edited) {
+                        auto& step = edited.lanes[l].steps[s];
+                        step.velocity = step.velocity > 0 ? 0 : 100;
+                    });
+                    mu_pop_id(ctx);
+                    return;
+                }
+                mu_pop_id(ctx);
+            }
+        }
+
+        if (selected_lane < 0 || static_cast<size_t>(selected_lane) >= sequence->lanes.size() || selected_step < 0 || static_cast<size_t>(selected_step) >= steps) {
+            return;
+        }
+
+        UI_SEPARATOR(ctx);
+
+        int scw[] = {width, -1};
+        mu_layout_row(ctx, 2, scw, 0);
+        mu_label(ctx, "Velocity:");
+        mu_number(ctx, &step_velocity, 1.0f);
+        mu_label(ctx, "Probability %:");
+        mu_number(ctx, &step_probability, 1.0f);
+        mu_label(ctx, "Ratchet:");
+        mu_number(ctx, &step_ratchet, 1.0f);
+        if (mu_button(ctx, "Apply To Step")) {
+            const auto lane = static_cast<size_t>(selected_lane);
+            const auto index = static_cast<size_t>(selected_step);
+            const audio::Sequencing::Step step{
+                static_cast<uint8_t>(std::clamp(step_velocity, 0.0f, 127.0f)),
+                static_cast<uint8_t>(std::clamp(step_probability, 0.0f, 100.0f)),
+                static_cast<uint8_t>(std::clamp(step_ratchet, 1.0f, 16.0f))
+            };
+            Edit(generator, [lane, index, step](audio::Sequencing::StepSequence& edited) {
+                edited.lanes[lane].steps[index] = step;
+            });
+        }
+    }
+} // Windows
+} // ui
@@ -0,0 +1,47 @@
+#ifndef STEPSEQUENCERWINDOW_H
+#define STEPSEQUENCERWINDOW_H
+#include <functional>
+
+#include "GeneratorsWindow.h"
+#include "audio/AudioBackend.h"
+#include "ui/Window.h"
+
+extern "C" {
+#include <microui.h>
+}
+
+#include "ui/ui_macros.h"
+
+namespace ui {
+namespace Windows {
+
+// Drum grid of the selected pattern for the selected generator. Clicking a step toggles it and selects it
+// for editing its velocity, probability and ratchets.
+class StepSequencerWindow final : public ui::Window {
+public:
+    StepSequencerWindow(audio::AudioBackend* backend, Windows::GeneratorsWindow* generators_window) : ui::Window("Step Sequencer", mu_rect(320, 410, 600, 300)), generators_window(generators_window), backend(backend) {
+    }
+
+protected:
+    void OnRender(mu_Context *ctx) override;
+private:
+    Windows::GeneratorsWindow* generators_window;
+    audio::AudioBackend* backend;
+    int64_t selected_pattern = -1;
+
+    float new_lane_pitch = 36.0f;
+    float step_count = 16.0f;
+    int selected_lane = -1;
+    int selected_step = -1;
+    float step_velocity = 100.0f;
+    float step_probability = 100.0f;
+    float step_ratchet = 1.0f;
+
+    // Applies an edit to this generator's step sequence in the selected pattern, as one undo step.
+    void Edit(audio::AudioGenerator* generator, const std::function<void(audio::Sequencing::StepSequence&)>& edit);
+};
+
+} // Windows
+} // ui
+
+#endif //STEPSEQUENCERWINDOW_H
@@ -0,0 +1,95 @@
+// Checks the error bounds documented in audio/fast_math.h against libm in double precision.
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+#include "audio/fast_math.h"
+
+namespace fast = audio::math::fast;
+
+namespace {
+    int failures = 0;
+
+    // Sweeps [lo, hi] in steps samples and compares the worst error against bound.
+    void check(const char* name, double lo, double hi, int steps, double bound, bool relative,
+               const std::function<float(float)>& approx, const std::function<double(double)>& reference) {
+        double worst = 0.0;
+        double worst_x = lo;
+        for (int i = 0; i <= steps; ++i) {
+            const auto x = static_cast<float>(lo + (hi - lo) * i / steps);
+            const double expected = reference(x);
+            double error = std::abs(static_cast<double>(approx(x)) - expected);
+            if (relative) {
+                error /= std::abs(expected);
+            }
+            if (!(error <= worst)) {
+                worst = error;
+                worst_x = x;
+            }
+        }
+
+        const bool ok = worst <= bound;
+        std::printf("%-6s %-22s [%g, %g] max %s error %.3g at %g (bound %.3g)\n", ok ? "ok" : "FAIL", name, lo, hi,
+                    relative ? "rel" : "abs", worst, worst_x, bound);
+        if (!ok) {
+            ++failures;
+        }
+    }
+
+    void check_wrap_phase() {
+        const float inputs[] = {-1e-8f, -1e-30f, -0.0f, 0.0f, 1e-8f, fast::two_pi, -fast::two_pi, fast::below_two_pi,
+                                -fast::below_two_pi, 1000.0f, -1000.0f, 123456.7f, -123456.7f};
+        bool ok = true;
+        for (float x : inputs) {
+            const float wrapped = fast::wrap_phase(x);
+            if (!(wrapped >= 0.0f && wrapped < fast::two_pi)) {
+                std::printf("FAIL   wrap_phase(%g) = %.9g, outside [0, 2pi)\n", x, wrapped);
+                ok = false;
+            }
+        }
+        for (int i = -200000; i <= 200000; ++i) {
+            const float x = static_cast<float>(i) * 1e-3f;
+            const float wrapped = fast::wrap_phase(x);
+            if (!(wrapped >= 0.0f && wrapped < fast::two_pi)) {
+                std::printf("FAIL   wrap_phase(%g) = %.9g, outside [0, 2pi)\n", x, wrapped);
+                ok = false;
+                break;
+            }
+        }
+        if (ok) {
+            std::printf("ok     wrap_phase stays in [0, 2pi)\n");
+        } else {
+            ++failures;
+        }
+    }
+}
+
+int main() {
+    check_wrap_phase();
+
+    // Distance on the circle, a wrapped phase just below 2π is as good as one just above 0
+    check("wrap_phase", -1000.0, 1000.0, 2000000, 6e-5, false,
+          [](float x) {
+              const double d = fast::wrap_phase(x) - std::fmod(static_cast<double>(x), 2.0 * M_PI);
+              return static_cast<float>(d - 2.0 * M_PI * std::round(d / (2.0 * M_PI)));
+          },
+          [](double) { return 0.0; });
+
+    check("sin", -20.0, 20.0, 2000000, 3e-7, false,
+          [](float x) { return fast::sin(x); }, [](double x) { return std::sin(x); });
+    check("sin", -65536.0, 65536.0, 2000000, 1.5e-6, false,
+          [](float x) { return fast::sin(x); }, [](double x) { return std::sin(x); });
+    check("cos", -100.0, 100.0, 2000000, 4e-6, false,
+          [](float x) { return fast::cos(x); }, [](double x) { return std::cos(x); });
+    check("exp2", -126.0, 127.0, 2000000, 2e-7, true,
+          [](float x) { return fast::exp2(x); }, [](double x) { return std::exp2(x); });
+    check("log2", 1.0 / 65536.0, 1.0, 2000000, 6e-7, false,
+          [](float x) { return fast::log2(x); }, [](double x) { return std::log2(x); });
+    check("log2", 1.0, 65536.0, 2000000, 6e-7, false,
+          [](float x) { return fast::log2(x); }, [](double x) { return std::log2(x); });
+    check("tanh", -20.0, 20.0, 2000000, 2e-7, false,
+          [](float x) { return fast::tanh(x); }, [](double x) { return std::tanh(x); });
+
+    return failures == 0 ? 0 : 1;
+}
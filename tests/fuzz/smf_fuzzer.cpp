@@ -0,0 +1,45 @@
+// libFuzzer target for the Standard MIDI File parser, see EVILSTUDIO_FUZZ in CMakeLists.txt.
+// Anything the parser accepts has to survive a write and a second parse with the same notes and tempo changes.
+
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+
+#include "audio/midi/MidiFile.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const auto file = audio::midi::parse_smf(std::span<const uint8_t>(data, size));
+    if (!file) {
+        return 0;
+    }
+
+    const auto written = audio::midi::write_smf(*file);
+    const auto reparsed = audio::midi::parse_smf(written);
+    if (!reparsed || reparsed->tracks.size() > file->tracks.size() || reparsed->tempo.size() != file->tempo.size()) {
+        std::abort();
+    }
+    for (size_t i = 0; i < file->tempo.size(); ++i) {
+        if (reparsed->tempo[i].tick != file->tempo[i].tick) {
+            std::abort();
+        }
+    }
+
+    // Tracks without notes are not written, the others come back with the same notes
+    size_t next = 0;
+    for (const auto& track : file->tracks) {
+        if (track.notes.empty()) {
+            continue;
+        }
+        if (next == reparsed->tracks.size() || reparsed->tracks[next].notes.size() != track.notes.size()) {
+            std::abort();
+        }
+        const auto& notes = reparsed->tracks[next].notes;
+        for (size_t n = 0; n < notes.size(); ++n) {
+            if (notes[n].tick != track.notes[n].tick || notes[n].pitch != track.notes[n].pitch) {
+                std::abort();
+            }
+        }
+        ++next;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Round trips Standard MIDI Files whose events are further apart than a single delta time can hold.
+
+#include <cstdio>
+#include <vector>
+
+#include "audio/midi/MidiFile.h"
+
+using namespace audio;
+
+namespace {
+    int failures = 0;
+
+    void report(bool ok, const char* name) {
+        std::printf("%-6s %s\n", ok ? "ok" : "FAIL", name);
+        if (!ok) {
+            ++failures;
+        }
+    }
+
+    bool same_notes(const midi::MidiFile& a, const midi::MidiFile& b) {
+        if (a.tracks.size() != b.tracks.size()) {
+            return false;
+        }
+        for (size_t t = 0; t < a.tracks.size(); ++t) {
+            const auto& x = a.tracks[t].notes;
+            const auto& y = b.tracks[t].notes;
+            if (x.size() != y.size()) {
+                return false;
+            }
+            for (size_t n = 0; n < x.size(); ++n) {
+                if (x[n].tick != y[n].tick || x[n].length != y[n].length || x[n].pitch != y[n].pitch) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool same_tempo(const midi::MidiFile& a, const midi::MidiFile& b) {
+        if (a.tempo.size() != b.tempo.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.tempo.size(); ++i) {
+            if (a.tempo[i].tick != b.tempo[i].tick) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    // Format 1, one track: a stray NoteOff and a tempo change each 0x0FFFFFFF ticks on, the change lands on
+    // tick 0x1FFFFFFE, further from the start of the written tempo track than one delta reaches
+    const std::vector<uint8_t> far_tempo = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 1, 0x03, 0xC0,
+        'M', 'T', 'r', 'k', 0, 0, 0, 21,
+        0xFF, 0xFF, 0xFF, 0x7F, 0x80, 60, 0,
+        0xFF, 0xFF, 0xFF, 0x7F, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+    std::string error;
+    const auto parsed = midi::parse_smf(far_tempo, &error);
+    report(parsed && parsed->tempo.size() == 1 && parsed->tempo[0].tick == 0x1FFFFFFE, "parse a tempo change 2^29 ticks in");
+    if (parsed) {
+        const auto reparsed = midi::parse_smf(midi::write_smf(*parsed), &error);
+        report(reparsed && same_tempo(*parsed, *reparsed), "round trip a tempo change 2^29 ticks in");
+    }
+
+    // Notes with gaps longer than one delta on either side of them
+    midi::MidiFile far_notes;
+    far_notes.tempo.push_back({0, 120.0});
+    far_notes.tempo.push_back({600'000'000, 90.0});
+    auto& track = far_notes.tracks.emplace_back();
+    for (const uint32_t tick : {0u, 536'870'910u, 536'870'911u, 4'000'000'000u}) {
+        Sequencing::Note note;
+        note.tick = tick;
+        note.length = tick == 536'870'910u ? 300'000'000u : 960u;
+        note.pitch = static_cast<uint8_t>(60 + track.notes.size());
+        note.velocity = 100;
+        track.notes.push_back(note);
+    }
+    const auto bytes = midi::write_smf(far_notes);
+    const auto notes = midi::parse_smf(bytes, &error);
+    report(notes && same_notes(far_notes, *notes) && same_tempo(far_notes, *notes), "round trip notes 2^29 ticks apart");
+
+    return failures == 0 ? 0 : 1;
+}
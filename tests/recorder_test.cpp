@@ -0,0 +1,83 @@
+// Records live notes against a looping transport and checks they land on the tick they were played at.
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "audio/Sequencing/Recorder.h"
+#include "audio/Sequencing/SequencerState.h"
+
+using namespace audio;
+using namespace audio::Sequencing;
+
+namespace {
+    struct SilentGenerator final : AudioGenerator {
+        SilentGenerator() : AudioGenerator("Silent") {}
+        void Process(float*, int, int, uint64_t) override {}
+    };
+
+    void wait(int milliseconds) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+
+    // Moves the output clock forward the way the audio callback does, a block at a time
+    void play(SequencerState& state, uint64_t until) {
+        while (state.get_current_process_sample() < until) {
+            state.processed(256);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+int main() {
+    SequencerState state;
+    Recorder recorder(state);
+    SilentGenerator generator;
+
+    {
+        auto lock = state.lock_patterns();
+        Pattern pattern;
+        pattern.id = 0;
+        state.patterns.push_back(pattern);
+    }
+    state.mark_dirty(0);
+
+    // Loop the second second of the song, the output starts at 0 on the loop start
+    const uint64_t loop_start = SAMPLE_RATE;
+    const uint64_t loop_end = 2 * SAMPLE_RATE;
+    state.set_loop({loop_start, loop_end, true});
+    state.seek(loop_start);
+    state.start();
+    wait(30);
+    recorder.arm(0);
+    wait(20);
+
+    // A short note 100 samples before the wraparound, captured while the old lap is still playing
+    const uint64_t wrap_output = loop_end - loop_start;
+    play(state, wrap_output - 256);
+    recorder.capture(&generator, {wrap_output - 100, 0, EventType::NoteOn, 60, 100});
+    recorder.capture(&generator, {wrap_output - 50, 0, EventType::NoteOff, 60, 0});
+
+    // Then well into the next lap before the recording thread gets to it
+    play(state, wrap_output + 8192);
+    wait(150);
+    recorder.disarm();
+    wait(100);
+
+    const uint64_t expected = TempoMap().tick_at(loop_end - 100);
+    int failures = 0;
+    auto lock = state.lock_patterns();
+    const auto& sequences = state.patterns[0].note_sequences;
+    if (sequences.size() != 1 || sequences[0].notes.size() != 1) {
+        std::printf("FAIL   expected one recorded note, got %zu sequences\n", sequences.size());
+        return 1;
+    }
+    const Note& note = *sequences[0].notes.begin();
+    const bool ok = note.tick == expected && note.pitch == 60;
+    std::printf("%-6s note before the loop wrap recorded at tick %u (expected %llu)\n", ok ? "ok" : "FAIL", note.tick,
+                static_cast<unsigned long long>(expected));
+    if (!ok) {
+        ++failures;
+    }
+    return failures == 0 ? 0 : 1;
+}
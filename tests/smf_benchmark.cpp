@@ -0,0 +1,61 @@
+// Times write_smf and parse_smf on a generated file, smf_benchmark [megabytes] (default 100).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "audio/midi/MidiFile.h"
+
+using namespace audio;
+
+namespace {
+    double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    const double megabytes = argc > 1 ? std::atof(argv[1]) : 100.0;
+
+    // Dense overlapping 16ths on 16 tracks, about 7 bytes per written note
+    constexpr size_t track_count = 16;
+    const auto notes_per_track = static_cast<size_t>(megabytes * 1024 * 1024 / 7 / track_count);
+    std::mt19937 random(1);
+    midi::MidiFile file;
+    file.tempo.push_back({0, 128.0});
+    for (size_t t = 0; t < track_count; ++t) {
+        auto& track = file.tracks.emplace_back();
+        track.channel = static_cast<uint8_t>(t);
+        track.notes.reserve(notes_per_track);
+        uint32_t tick = 0;
+        for (size_t n = 0; n < notes_per_track; ++n) {
+            tick += random() % 3 * (Sequencing::TempoMap::ticks_per_quarter / 4);
+            Sequencing::Note note;
+            note.tick = tick;
+            note.length = 60 + random() % 900;
+            note.pitch = static_cast<uint8_t>(36 + random() % 48);
+            note.velocity = static_cast<uint8_t>(1 + random() % 127);
+            track.notes.push_back(note);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const auto bytes = midi::write_smf(file);
+    const double write_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    std::string error;
+    const auto parsed = midi::parse_smf(bytes, &error);
+    const double parse_seconds = seconds_since(start);
+    if (!parsed) {
+        std::printf("parse failed: %s\n", error.c_str());
+        return 1;
+    }
+
+    const double size = static_cast<double>(bytes.size()) / (1024 * 1024);
+    std::printf("%.1f MB, %zu notes\n", size, track_count * notes_per_track);
+    std::printf("write %.3f s (%.0f MB/s)\n", write_seconds, size / write_seconds);
+    std::printf("parse %.3f s (%.0f MB/s)\n", parse_seconds, size / parse_seconds);
+    return 0;
+}